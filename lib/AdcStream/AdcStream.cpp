@@ -0,0 +1,307 @@
+// AdcStream: implementation
+
+#include "AdcStream.h"
+
+#include <atomic>
+
+#if __has_include(<esp_adc/adc_continuous.h>)
+#include <esp_adc/adc_continuous.h>
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_idf_version.h>
+#define ADC_STREAM_HAS_CONTINUOUS 1
+#else
+#define ADC_STREAM_HAS_CONTINUOUS 0
+#endif
+
+namespace
+{
+  constexpr BaseType_t CORE_APP = 1;
+  constexpr UBaseType_t PRIO_READER = tskIDLE_PRIORITY + 3; // above DRV8874 control tasks: keep data fresh
+
+  uint8_t s_pins[AdcStream::MAX_PINS] = {};
+  uint8_t s_pinCount = 0;
+
+  // Published results (single writer: reader task)
+  std::atomic<uint32_t> s_mV[AdcStream::MAX_PINS];
+  std::atomic<uint32_t> s_blockCount{0};
+
+  // Reader task state
+  uint32_t s_filtQ8[AdcStream::MAX_PINS] = {}; // IIR state, mV in Q8
+  bool s_filtPrimed[AdcStream::MAX_PINS] = {};
+  AdcStream::SampleSink s_sink[AdcStream::MAX_PINS] = {};
+  void *s_sinkCtx[AdcStream::MAX_PINS] = {};
+  TaskHandle_t s_task = nullptr;
+  SemaphoreHandle_t s_lock = nullptr; // serializes reconfiguration against the reader
+
+  void publish(uint8_t slot, uint32_t blockmV)
+  {
+    if (!s_filtPrimed[slot])
+    {
+      s_filtQ8[slot] = blockmV << 8;
+      s_filtPrimed[slot] = true;
+    }
+    else
+    {
+      const int32_t diff = int32_t(blockmV << 8) - int32_t(s_filtQ8[slot]);
+      s_filtQ8[slot] = uint32_t(int32_t(s_filtQ8[slot]) + (diff >> AdcStream::IIR_SHIFT));
+    }
+    s_mV[slot].store(s_filtQ8[slot] >> 8, std::memory_order_relaxed);
+  }
+
+#if ADC_STREAM_HAS_CONTINUOUS
+  // ESP32 (TYPE1 output format): 2 bytes per conversion
+  constexpr uint32_t MAX_FRAME_BYTES =
+      AdcStream::FRAME_CONVERSIONS_PER_PIN * AdcStream::MAX_PINS * SOC_ADC_DIGI_RESULT_BYTES;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+  constexpr adc_atten_t ATTEN = ADC_ATTEN_DB_12; // full 0..~3.1 V range for CS up to 2 A
+#else
+  constexpr adc_atten_t ATTEN = ADC_ATTEN_DB_11;
+#endif
+  constexpr uint8_t NO_SLOT = 0xFF;
+
+  adc_continuous_handle_t s_handle = nullptr;
+  uint32_t s_frameBytes = 0; // FRAME_CONVERSIONS_PER_PIN for each attached pin
+  adc_cali_handle_t s_cali = nullptr;
+  uint8_t s_channelToSlot[SOC_ADC_CHANNEL_NUM(ADC_UNIT_1)];
+
+  bool IRAM_ATTR onConvDone(adc_continuous_handle_t, const adc_continuous_evt_data_t *, void *)
+  {
+    BaseType_t woken = pdFALSE;
+    if (s_task)
+      vTaskNotifyGiveFromISR(s_task, &woken);
+    return woken == pdTRUE;
+  }
+
+  uint32_t rawTomV(uint32_t raw)
+  {
+    int mV = 0;
+    if (s_cali && adc_cali_raw_to_voltage(s_cali, int(raw), &mV) == ESP_OK)
+      return uint32_t(mV);
+    return (raw * 3300u) / 4095u; // uncalibrated estimate
+  }
+
+  // Reduce one DMA frame to per-pin boxcar averages and publish
+  void processFrame(const uint8_t *buf, uint32_t len)
+  {
+    uint32_t sum[AdcStream::MAX_PINS] = {};
+    uint16_t cnt[AdcStream::MAX_PINS] = {};
+
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES)
+    {
+      const auto *p = reinterpret_cast<const adc_digi_output_data_t *>(&buf[i]);
+      const uint32_t ch = p->type1.channel;
+      if (ch >= sizeof(s_channelToSlot) || s_channelToSlot[ch] == NO_SLOT)
+        continue;
+      const uint8_t slot = s_channelToSlot[ch];
+      if (s_sink[slot])
+        s_sink[slot](s_sinkCtx[slot], p->type1.data);
+      sum[slot] += p->type1.data;
+      cnt[slot]++;
+    }
+
+    for (uint8_t slot = 0; slot < s_pinCount; ++slot)
+      if (cnt[slot])
+        publish(slot, rawTomV(sum[slot] / cnt[slot]));
+    s_blockCount.fetch_add(1, std::memory_order_release);
+  }
+
+  void readerTaskEntry(void *)
+  {
+    static uint8_t frame[MAX_FRAME_BYTES];
+    for (;;)
+    {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      xSemaphoreTake(s_lock, portMAX_DELAY);
+      uint32_t got = 0;
+      while (s_handle && adc_continuous_read(s_handle, frame, s_frameBytes, &got, 0) == ESP_OK)
+        processFrame(frame, got);
+      xSemaphoreGive(s_lock);
+    }
+  }
+
+  void stopDriver()
+  {
+    if (!s_handle)
+      return;
+    adc_continuous_stop(s_handle);
+    adc_continuous_deinit(s_handle);
+    s_handle = nullptr;
+  }
+
+  bool startDriver()
+  {
+    if (!s_cali)
+    {
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+      adc_cali_line_fitting_config_t cc = {};
+      cc.unit_id = ADC_UNIT_1;
+      cc.atten = ATTEN;
+      cc.bitwidth = ADC_BITWIDTH_12;
+      if (adc_cali_create_scheme_line_fitting(&cc, &s_cali) != ESP_OK)
+        s_cali = nullptr;
+#endif
+    }
+
+    s_frameBytes = AdcStream::FRAME_CONVERSIONS_PER_PIN * s_pinCount * SOC_ADC_DIGI_RESULT_BYTES;
+    adc_continuous_handle_cfg_t hc = {};
+    hc.max_store_buf_size = s_frameBytes * 4;
+    hc.conv_frame_size = s_frameBytes;
+    if (adc_continuous_new_handle(&hc, &s_handle) != ESP_OK)
+    {
+      s_handle = nullptr;
+      return false;
+    }
+
+    memset(s_channelToSlot, NO_SLOT, sizeof(s_channelToSlot));
+    adc_digi_pattern_config_t pattern[AdcStream::MAX_PINS] = {};
+    for (uint8_t i = 0; i < s_pinCount; ++i)
+    {
+      adc_unit_t unit;
+      adc_channel_t ch;
+      adc_continuous_io_to_channel(s_pins[i], &unit, &ch);
+      pattern[i].atten = ATTEN;
+      pattern[i].channel = ch;
+      pattern[i].unit = ADC_UNIT_1;
+      pattern[i].bit_width = ADC_BITWIDTH_12;
+      s_channelToSlot[ch] = i;
+    }
+
+    adc_continuous_config_t cfg = {};
+    cfg.pattern_num = s_pinCount;
+    cfg.adc_pattern = pattern;
+    cfg.sample_freq_hz = AdcStream::PER_PIN_RATE_HZ * s_pinCount; // round-robin: every pin keeps its rate
+    cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+    adc_continuous_evt_cbs_t cbs = {};
+    cbs.on_conv_done = onConvDone;
+
+    if (adc_continuous_config(s_handle, &cfg) != ESP_OK ||
+        adc_continuous_register_event_callbacks(s_handle, &cbs, nullptr) != ESP_OK ||
+        adc_continuous_start(s_handle) != ESP_OK)
+    {
+      Serial.println("AdcStream: continuous ADC start failed");
+      adc_continuous_deinit(s_handle);
+      s_handle = nullptr;
+      return false;
+    }
+    return true;
+  }
+
+  bool isAdc1Pin(uint8_t pin)
+  {
+    adc_unit_t unit;
+    adc_channel_t ch;
+    return adc_continuous_io_to_channel(pin, &unit, &ch) == ESP_OK && unit == ADC_UNIT_1;
+  }
+
+#else // polling fallback
+
+  void readerTaskEntry(void *)
+  {
+    const TickType_t period = pdMS_TO_TICKS(1000 / AdcStream::FALLBACK_POLL_HZ);
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t sum[AdcStream::MAX_PINS] = {};
+    uint8_t n = 0;
+
+    for (;;)
+    {
+      xSemaphoreTake(s_lock, portMAX_DELAY);
+      for (uint8_t slot = 0; slot < s_pinCount; ++slot)
+        sum[slot] += analogReadMilliVolts(s_pins[slot]);
+      if (++n >= AdcStream::FALLBACK_BLOCK)
+      {
+        for (uint8_t slot = 0; slot < s_pinCount; ++slot)
+        {
+          publish(slot, sum[slot] / n);
+          sum[slot] = 0;
+        }
+        n = 0;
+        s_blockCount.fetch_add(1, std::memory_order_release);
+      }
+      xSemaphoreGive(s_lock);
+      vTaskDelayUntil(&lastWake, period);
+    }
+  }
+
+  void stopDriver() {}
+
+  bool startDriver()
+  {
+    analogReadResolution(12);
+    for (uint8_t i = 0; i < s_pinCount; ++i)
+      analogSetPinAttenuation(s_pins[i], ADC_11db);
+    return true;
+  }
+
+  bool isAdc1Pin(uint8_t pin) { return digitalPinToAnalogChannel(pin) >= 0 && digitalPinToAnalogChannel(pin) < 8; }
+#endif
+
+} // namespace
+
+namespace AdcStream
+{
+  int8_t attach(uint8_t pin)
+  {
+    for (uint8_t i = 0; i < s_pinCount; ++i)
+      if (s_pins[i] == pin)
+        return int8_t(i);
+
+    if (s_pinCount >= MAX_PINS || !isAdc1Pin(pin))
+    {
+      Serial.printf("AdcStream: can't attach pin %u\n", (unsigned)pin);
+      return -1;
+    }
+
+    if (!s_lock)
+      s_lock = xSemaphoreCreateMutex();
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    stopDriver();
+    const uint8_t slot = s_pinCount;
+    s_pins[slot] = pin;
+    s_mV[slot].store(0, std::memory_order_relaxed);
+    s_filtPrimed[slot] = false;
+    s_pinCount++;
+    const bool ok = startDriver();
+    xSemaphoreGive(s_lock);
+
+    if (!s_task)
+      xTaskCreatePinnedToCore(readerTaskEntry, "adc_stream", 3072, nullptr, PRIO_READER, &s_task, CORE_APP);
+
+    Serial.printf("AdcStream: pin %u -> slot %u, %s, %lu Hz/pin\n", (unsigned)pin, (unsigned)slot,
+                  isContinuous() ? "continuous" : "polling", (unsigned long)perPinRateHz());
+    return ok ? int8_t(slot) : -1;
+  }
+
+  uint32_t readMilliVolts(int8_t slot)
+  {
+    if (slot < 0 || slot >= int8_t(s_pinCount))
+      return 0;
+    return s_mV[slot].load(std::memory_order_relaxed);
+  }
+
+  bool setSampleSink(int8_t slot, SampleSink sink, void *ctx)
+  {
+    if (slot < 0 || slot >= int8_t(s_pinCount) || !isContinuous())
+      return false;
+    xSemaphoreTake(s_lock, portMAX_DELAY); // reader holds it while processing frames
+    s_sink[slot] = sink;
+    s_sinkCtx[slot] = ctx;
+    xSemaphoreGive(s_lock);
+    return true;
+  }
+
+  uint32_t blockCount() { return s_blockCount.load(std::memory_order_acquire); }
+
+  uint32_t perPinRateHz()
+  {
+    if (!isContinuous())
+      return FALLBACK_POLL_HZ;
+    return s_pinCount ? PER_PIN_RATE_HZ : 0;
+  }
+
+  bool isContinuous() { return ADC_STREAM_HAS_CONTINUOUS != 0; }
+
+} // namespace AdcStream
@@ -0,0 +1,41 @@
+// AdcStream: shared high-rate ADC1 sampler for several pins (motor current sense etc.).
+// ESP-IDF 5 (Arduino-ESP32 3.x): continuous DMA driver, round-robin over all attached pins.
+// Older cores: single polling task fallback with the same API.
+// One reader task reduces each DMA frame to a per-pin boxcar average, smooths it across
+// frames with a fixed-point IIR and publishes millivolts lock-free for any reader.
+
+#pragma once
+#include <Arduino.h>
+
+namespace AdcStream
+{
+  constexpr uint8_t MAX_PINS = 4;
+  constexpr uint32_t PER_PIN_RATE_HZ = 10000;       // conversions/s of each pin: the total grows with the pins
+  constexpr uint16_t FRAME_CONVERSIONS_PER_PIN = 16; // per pin and DMA frame → block rate 625 Hz
+  constexpr uint8_t IIR_SHIFT = 1;                   // block smoothing: y += (x - y) >> IIR_SHIFT (0 = off)
+  constexpr uint32_t FALLBACK_POLL_HZ = 1000;        // per-pin rate of the polling fallback
+  constexpr uint8_t FALLBACK_BLOCK = 8;              // polled samples per published block
+
+  // Attach an ADC1 pin and (re)start sampling with all attached pins. Idempotent per pin.
+  // Returns the slot used for reads or -1 if the pin isn't usable / no slot left.
+  int8_t attach(uint8_t pin);
+
+  // Last filtered value of a slot in millivolts (0 for invalid slot). Lock-free.
+  uint32_t readMilliVolts(int8_t slot);
+
+  // Optional per-conversion hook (raw 12-bit counts) for signal processing at the full per-pin
+  // rate, e.g. current ripple counting. Continuous mode only: never called by the polling fallback.
+  // Runs in the reader task: keep it short and non-blocking. Pass nullptr to remove.
+  using SampleSink = void (*)(void *ctx, uint16_t raw);
+  bool setSampleSink(int8_t slot, SampleSink sink, void *ctx);
+
+  // Number of published blocks so far (wraps). Lets readers detect fresh data.
+  uint32_t blockCount();
+
+  // Effective per-pin sample rate (PER_PIN_RATE_HZ in continuous mode, 0 with no pin attached)
+  uint32_t perPinRateHz();
+
+  // True if running on the continuous DMA driver (false: polling fallback)
+  bool isContinuous();
+
+} // namespace AdcStream
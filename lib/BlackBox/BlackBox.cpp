@@ -0,0 +1,212 @@
+// BlackBox: implementation
+
+#include "BlackBox.h"
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <new>
+
+namespace
+{
+  constexpr uint32_t STORE_MAGIC = 0xB1ACB0C5;
+
+  struct Store
+  {
+    uint32_t magic;
+    uint32_t bootCount;
+    uint16_t head;  // next write index
+    uint16_t count; // valid records
+    uint8_t frozen;
+    uint8_t reason;     // BlackBox::Reason
+    uint8_t resetReason; // esp_reset_reason() of the boot that froze it
+    uint8_t reserved;
+    uint32_t frozenAtMs; // millis() when frozen (of the boot that recorded)
+    BlackBoxRecord rec[BlackBox::RECORDS];
+  };
+
+  RTC_NOINIT_ATTR Store s_store; // survives software/panic/watchdog resets, random after power-on
+  SemaphoreHandle_t s_lock = nullptr; // s_store: loop (record/freeze) vs AsyncTCP (dump/clear/freeze)
+
+  // Copy of the store taken under the lock; the web handlers format from it without holding it
+  void snapshot(Store &out)
+  {
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    memcpy(&out, &s_store, sizeof(Store));
+    xSemaphoreGive(s_lock);
+  }
+
+  bool storeValid()
+  {
+    return s_store.magic == STORE_MAGIC && s_store.head < BlackBox::RECORDS && s_store.count <= BlackBox::RECORDS;
+  }
+
+  void reset()
+  {
+    s_store.magic = STORE_MAGIC;
+    s_store.head = 0;
+    s_store.count = 0;
+    s_store.frozen = 0;
+    s_store.reason = BlackBox::REASON_NONE;
+    s_store.resetReason = 0;
+    s_store.frozenAtMs = 0;
+  }
+
+  const char *reasonName(uint8_t r)
+  {
+    switch (r)
+    {
+    case BlackBox::REASON_FAULT:
+      return "fault";
+    case BlackBox::REASON_PANIC:
+      return "panic";
+    case BlackBox::REASON_WATCHDOG:
+      return "watchdog";
+    case BlackBox::REASON_BROWNOUT:
+      return "brownout";
+    case BlackBox::REASON_MANUAL:
+      return "manual";
+    default:
+      return "none";
+    }
+  }
+} // namespace
+
+namespace BlackBox
+{
+  void begin()
+  {
+    if (!s_lock)
+      s_lock = xSemaphoreCreateMutex();
+    const esp_reset_reason_t rr = esp_reset_reason();
+    if (!storeValid())
+    {
+      reset();
+      s_store.bootCount = 0;
+    }
+    s_store.bootCount++;
+
+    Reason reason = REASON_NONE;
+    switch (rr)
+    {
+    case ESP_RST_PANIC:
+      reason = REASON_PANIC;
+      break;
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+      reason = REASON_WATCHDOG;
+      break;
+    case ESP_RST_BROWNOUT:
+      reason = REASON_BROWNOUT;
+      break;
+    default:
+      break;
+    }
+    if (reason != REASON_NONE && s_store.count > 0 && !s_store.frozen)
+    {
+      s_store.frozen = 1;
+      s_store.reason = reason;
+      s_store.resetReason = uint8_t(rr);
+      s_store.frozenAtMs = s_store.rec[(s_store.head + RECORDS - 1) % RECORDS].ms;
+    }
+    Serial.printf("BlackBox: boot %lu reset reason %d, %u records%s%s\n", (unsigned long)s_store.bootCount, (int)rr,
+                  (unsigned)s_store.count, s_store.frozen ? ", frozen: " : "", s_store.frozen ? reasonName(s_store.reason) : "");
+  }
+
+  void record(const BlackBoxRecord &rec)
+  {
+    if (!s_lock || s_store.frozen)
+      return;
+    xSemaphoreTake(s_lock, portMAX_DELAY); // held only for copies, never across formatting
+    if (!s_store.frozen)
+    {
+      s_store.rec[s_store.head] = rec;
+      s_store.head = (s_store.head + 1) % RECORDS;
+      if (s_store.count < RECORDS)
+        s_store.count++;
+    }
+    xSemaphoreGive(s_lock);
+  }
+
+  void freeze(Reason reason)
+  {
+    if (!s_lock)
+      return;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    const bool first = !s_store.frozen;
+    if (first)
+    {
+      s_store.frozen = 1;
+      s_store.reason = reason;
+      s_store.resetReason = 0;
+      s_store.frozenAtMs = millis();
+    }
+    const uint16_t count = s_store.count;
+    xSemaphoreGive(s_lock);
+    if (first)
+      Serial.printf("BlackBox: frozen (%s), %u records\n", reasonName(reason), (unsigned)count);
+  }
+
+  bool isFrozen() { return s_store.frozen != 0; }
+
+  void clear()
+  {
+    if (!s_lock)
+      return;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    const uint32_t boots = s_store.bootCount;
+    reset();
+    s_store.bootCount = boots;
+    xSemaphoreGive(s_lock);
+  }
+
+  void attachRoutes(AsyncWebServer &server)
+  {
+    server.on("/blackbox/api/status", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      if (!s_lock) { req->send(503, "text/plain", "not started"); return; }
+      xSemaphoreTake(s_lock, portMAX_DELAY);
+      const bool frozen = s_store.frozen;
+      const uint8_t reason = s_store.reason;
+      const uint8_t resetReason = s_store.resetReason;
+      const uint32_t frozenAtMs = s_store.frozenAtMs;
+      const uint16_t count = s_store.count;
+      const uint32_t bootCount = s_store.bootCount;
+      xSemaphoreGive(s_lock);
+      AsyncResponseStream *res = req->beginResponseStream("application/json");
+      res->printf("{\"frozen\":%s,\"reason\":\"%s\",\"resetReason\":%u,\"frozenAtMs\":%lu,\"count\":%u,\"bootCount\":%lu}",
+                  frozen ? "true" : "false", reasonName(reason), (unsigned)resetReason,
+                  (unsigned long)frozenAtMs, (unsigned)count, (unsigned long)bootCount);
+      req->send(res); });
+
+    server.on("/blackbox/api/dump", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      Store *snap = s_lock ? new (std::nothrow) Store : nullptr;
+      if (!snap) { req->send(503, "text/plain", "no memory"); return; }
+      snapshot(*snap); // record() keeps running while the CSV is formatted
+      AsyncResponseStream *res = req->beginResponseStream("text/csv");
+      res->print("ms,m1_duty,m2_duty,m1_mA,m2_mA,buttons,flags,timer_ds\n");
+      const uint16_t first = (snap->head + RECORDS - snap->count) % RECORDS;
+      for (uint16_t i = 0; i < snap->count; ++i)
+      {
+        const BlackBoxRecord &r = snap->rec[(first + i) % RECORDS];
+        res->printf("%lu,%d,%d,%u,%u,0x%02x,0x%02x,%u\n", (unsigned long)r.ms, (int)r.duty[0], (int)r.duty[1],
+                    (unsigned)r.mA[0], (unsigned)r.mA[1], (unsigned)r.buttons, (unsigned)r.flags, (unsigned)r.timerDs);
+      }
+      delete snap;
+      req->send(res); });
+
+    server.on("/blackbox/api/freeze", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      freeze(REASON_MANUAL);
+      req->send(200, "application/json", "{\"ok\":true}"); });
+
+    server.on("/blackbox/api/clear", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      clear();
+      req->send(200, "application/json", "{\"ok\":true}"); });
+  }
+
+} // namespace BlackBox
@@ -0,0 +1,64 @@
+// BlackBox: always-on pre-trigger ring of control state in RTC slow memory (RTC_NOINIT), so the
+// last ~RECORDS loop iterations before a driver fault, panic, watchdog or brownout reset survive
+// the reboot. Frozen on fault or on request (freeze()), or at boot after an abnormal reset;
+// recording resumes after clear(). Fixed-size records, no allocations: record() is a 16-byte copy.
+
+#pragma once
+
+#include <stdint.h>
+
+class AsyncWebServer;
+
+struct __attribute__((packed)) BlackBoxRecord
+{
+  uint32_t ms = 0;         // millis() at record time
+  int16_t duty[2] = {};    // applied duty × direction, motor 1/2
+  uint16_t mA[2] = {};     // CS current
+  uint8_t buttons = 0;     // TM1638 buttons mask
+  uint8_t flags = 0;       // BlackBox::FLAG_* bits
+  uint16_t timerDs = 0;    // timer remaining, 0.1 s units
+};
+static_assert(sizeof(BlackBoxRecord) == 16, "BlackBoxRecord must be 16 bytes");
+
+namespace BlackBox
+{
+  constexpr uint16_t RECORDS = 128; // 2 KB of RTC slow memory
+
+  enum Flag : uint8_t
+  {
+    FLAG_LAMP = 0x01,
+    FLAG_TIMER = 0x02, // timer running
+    FLAG_FAULT1 = 0x04,
+    FLAG_FAULT2 = 0x08,
+    FLAG_STALL1 = 0x10,
+    FLAG_STALL2 = 0x20,
+    FLAG_CONFLICT = 0x40, // up+down pressed together
+  };
+
+  enum Reason : uint8_t
+  {
+    REASON_NONE = 0,
+    REASON_FAULT = 1,    // driver FAULT (freeze())
+    REASON_PANIC = 2,    // reset reasons detected at boot
+    REASON_WATCHDOG = 3,
+    REASON_BROWNOUT = 4,
+    REASON_MANUAL = 5,   // POST /blackbox/api/freeze
+  };
+
+  // Validate the RTC store (fresh after power-on) and freeze it if the last reset was abnormal.
+  void begin();
+
+  // Append one record unless frozen. Call from one task (loop); the web handlers copy the ring
+  // under a short lock, so a dump never sees a half-written record.
+  void record(const BlackBoxRecord &rec);
+
+  // Stop recording and keep the history (first reason wins until clear())
+  void freeze(Reason reason);
+  bool isFrozen();
+  void clear();
+
+  // GET /blackbox/api/dump (CSV, oldest first), GET /blackbox/api/status,
+  // POST /blackbox/api/freeze (manual trigger), POST /blackbox/api/clear
+  void attachRoutes(AsyncWebServer &server);
+
+} // namespace BlackBox
@@ -34,83 +34,281 @@ void Buzzer::begin(uint32_t basePwmFreq, uint8_t resolutionBits)
         digitalWrite(_ledPin, LOW);
     }
 
-    // Create the one-shot timer once
+    // Create the timers once
+    if (_kickTimer == nullptr)
+    {
+        esp_timer_create_args_t args = {};
+        args.callback = &Buzzer::timerKickCb;
+        args.arg = this;
+        args.name = "beepKick";
+        esp_timer_create(&args, &_kickTimer);
+    }
     if (_timer == nullptr)
     {
         esp_timer_create_args_t args = {};
-        args.callback = &Buzzer::timerStopCb;
+        args.callback = &Buzzer::timerStepCb;
         args.arg = this;
-        args.name = "beepStop";
+        args.name = "beepStep";
         esp_timer_create(&args, &_timer);
     }
+    if (_metroTimer == nullptr)
+    {
+        esp_timer_create_args_t args = {};
+        args.callback = &Buzzer::timerMetroCb;
+        args.arg = this;
+        args.name = "beepMetro";
+        esp_timer_create(&args, &_metroTimer);
+    }
+}
+
+void Buzzer::buzz(uint16_t tone_ms, uint16_t volume, uint32_t freq, Priority prio)
+{
+    Step step;
+    step.ms = tone_ms;
+    step.freq = uint16_t(freq > UINT16_MAX ? UINT16_MAX : freq);
+    step.volume = volume;
+    play(&step, 1, prio);
 }
 
-void Buzzer::buzz(uint16_t tone_ms, uint16_t volume, uint32_t freq)
+bool Buzzer::play(const Step *steps, uint8_t count, Priority prio, uint8_t repeat)
 {
-    // Start tone (duty acts as "volume"); stop any pending timer first.
-    if (_timer)
+    if (!_kickTimer || !_timer || count == 0 || repeat == 0)
+        return false;
+    if (count > MAX_STEPS)
+        count = MAX_STEPS;
+
+    portENTER_CRITICAL(&_mux);
+    // The same pattern already playing or queued: let it run instead of restarting it
+    for (uint8_t i = 0; i < MAX_QUEUE; ++i)
+        if (_queue[i].count == count && _queue[i].prio == prio && memcmp(_queue[i].steps, steps, sizeof(Step) * count) == 0)
+        {
+            portEXIT_CRITICAL(&_mux);
+            return true;
+        }
+
+    // Free slot, or else the lowest priority one below prio (not the playing one unless preempted)
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < MAX_QUEUE && slot < 0; ++i)
+        if (_queue[i].count == 0)
+            slot = int8_t(i);
+    if (slot < 0)
+        for (uint8_t i = 0; i < MAX_QUEUE; ++i)
+            if (_queue[i].prio < prio && (slot < 0 || _queue[i].prio < _queue[slot].prio))
+                slot = int8_t(i);
+    if (slot < 0)
     {
-        esp_timer_stop(_timer);
+        portEXIT_CRITICAL(&_mux);
+        return false;
     }
-    // Set tone and volume
-#if ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
-    ledcWriteTone(_pin, freq); // pin-based API
-    ledcWrite(_pin, volume);
-#else
-    ledcWriteTone(_ch, freq); // channel-based API
-    ledcWrite(_ch, volume);
-#endif
-    if (_ledPin >= 0)
-        digitalWrite(_ledPin, HIGH);
 
-    _active = true;
+    Pattern &p = _queue[slot];
+    memcpy(p.steps, steps, sizeof(Step) * count);
+    p.count = count;
+    p.repeat = repeat;
+    p.prio = prio;
+    p.order = _order++;
 
-    // Arm one-shot to stop after tone_ms (convert ms -> us)
-    if (_timer)
+    const bool startNow = _cur < 0 || prio > _queue[_cur].prio || slot == _cur;
+    if (startNow)
     {
-        esp_timer_start_once(_timer, static_cast<uint64_t>(tone_ms) * 1000ULL);
+        if (_cur >= 0 && slot != _cur) // preempted pattern is dropped, not resumed
+            _queue[_cur].count = 0;
+        _cur = slot;
+        _step = 0;
+        _restart = true;
     }
+    portEXIT_CRITICAL(&_mux);
+    if (startNow)
+        kick();
+    return true;
 }
 
 void Buzzer::stop()
 {
-    // Immediately silence and clear LED
-    // Immediately silence and clear LED
-#if ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
-    ledcWriteTone(_pin, 0);
-    ledcWrite(_pin, 0);
-#else
-    ledcWriteTone(_ch, 0);
-    ledcWrite(_ch, 0);
-#endif
-    if (_ledPin >= 0)
-        digitalWrite(_ledPin, LOW);
-    _active = false;
+    if (!_kickTimer)
+        return;
+    portENTER_CRITICAL(&_mux);
+    for (uint8_t i = 0; i < MAX_QUEUE; ++i)
+        _queue[i].count = 0;
+    _cur = -1;
+    _restart = true;
+    portEXIT_CRITICAL(&_mux);
+    kick();
+}
+
+void Buzzer::startMetronome(uint32_t durationMs, uint16_t periodMs, uint8_t countdownTicks)
+{
+    if (!_kickTimer || !_metroTimer || periodMs == 0)
+        return;
+    portENTER_CRITICAL(&_mux);
+    _metroTicksLeft = durationMs > 0 ? (durationMs - 1) / periodMs : 0; // ticks strictly inside
+    _metroCountdown = countdownTicks;
+    _metroPeriodMs = periodMs;
+    _metroRestart = true;
+    portEXIT_CRITICAL(&_mux);
+    kick();
+}
+
+void Buzzer::stopMetronome()
+{
+    if (!_kickTimer || !_metroTimer)
+        return;
+    portENTER_CRITICAL(&_mux);
+    _metroTicksLeft = 0;
+    _metroRestart = true;
+    portEXIT_CRITICAL(&_mux);
+    kick();
+}
 
-    if (_timer)
+void Buzzer::timerKickCb(void *arg)
+{
+    // Timer callbacks run in the esp_timer task—keep quick.
+    static_cast<Buzzer *>(arg)->handleKick();
+}
+
+void Buzzer::timerStepCb(void *arg)
+{
+    static_cast<Buzzer *>(arg)->handleStep();
+}
+
+void Buzzer::timerMetroCb(void *arg)
+{
+    static_cast<Buzzer *>(arg)->handleTick();
+}
+
+void Buzzer::kick()
+{
+    // Fails while a kick is already pending: that one picks up this change too
+    esp_timer_start_once(_kickTimer, 1);
+}
+
+void Buzzer::handleKick()
+{
+    Output out;
+    portENTER_CRITICAL(&_mux);
+    const bool metroRestart = _metroRestart;
+    const bool metroRun = _metroTicksLeft > 0;
+    const uint64_t metroPeriodUs = uint64_t(_metroPeriodMs) * 1000ULL;
+    _metroRestart = false;
+    if (_restart)
     {
-        // If someone calls stop() manually, make sure any pending one-shot is disarmed.
-        esp_timer_stop(_timer);
+        _restart = false;
+        if (_cur >= 0)
+            playStepLocked(out);
+        else
+        {
+            out.write = true; // silence
+            out.stopStep = true;
+        }
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (metroRestart)
+    {
+        esp_timer_stop(_metroTimer);
+        if (metroRun)
+            esp_timer_start_periodic(_metroTimer, metroPeriodUs); // drift-free
+    }
+    apply(out);
+}
+
+void Buzzer::handleStep()
+{
+    Output out;
+    portENTER_CRITICAL(&_mux);
+    if (_restart)
+    {
+        // A new pattern waits for the pending kick: this expiry ended a step of the old one
+    }
+    else if (_cur >= 0)
+    {
+        Pattern &p = _queue[_cur];
+        if (++_step >= p.count)
+        {
+            _step = 0;
+            if (--p.repeat == 0)
+                p.count = 0;
+        }
+        if (p.count)
+            playStepLocked(out);
+        else
+            startNextLocked(out);
+    }
+    else
+        out.write = true; // metronome tick over
+    portEXIT_CRITICAL(&_mux);
+    apply(out);
+}
+
+void Buzzer::handleTick()
+{
+    Output out;
+    bool last = true;
+    portENTER_CRITICAL(&_mux);
+    if (_metroTicksLeft > 0)
+    {
+        const bool accent = _metroTicksLeft <= _metroCountdown;
+        last = --_metroTicksLeft == 0;
+        if (_cur < 0) // a click, not a queued pattern: never delays real beeps
+        {
+            out.write = true;
+            out.freq = accent ? 3000 : 2000;
+            out.volume = 255;
+            out.stepUs = accent ? 40000 : 15000;
+        }
     }
+    portEXIT_CRITICAL(&_mux);
+    if (last)
+        esp_timer_stop(_metroTimer);
+    apply(out);
 }
 
-void Buzzer::timerStopCb(void *arg)
+void Buzzer::apply(const Output &out)
 {
-    // Timer callbacks run in a system context—keep quick.
-    static_cast<Buzzer *>(arg)->handleStop();
+    if (out.write)
+        writeTone(out.freq, out.volume);
+    if (out.stopStep || out.stepUs)
+        esp_timer_stop(_timer);
+    if (out.stepUs)
+        esp_timer_start_once(_timer, out.stepUs);
 }
 
-void Buzzer::handleStop()
+void Buzzer::writeTone(uint32_t freq, uint16_t volume)
 {
-    // Mirror your original stop_buzz_cb()
 #if ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
-    ledcWriteTone(_pin, 0);
-    ledcWrite(_pin, 0);
+    ledcWriteTone(_pin, freq); // pin-based API
+    ledcWrite(_pin, freq ? volume : 0);
 #else
-    ledcWriteTone(_ch, 0);
-    ledcWrite(_ch, 0);
+    ledcWriteTone(_ch, freq); // channel-based API
+    ledcWrite(_ch, freq ? volume : 0);
 #endif
+    const bool on = freq != 0 && volume != 0;
     if (_ledPin >= 0)
-        digitalWrite(_ledPin, LOW);
-    _active = false;
+        digitalWrite(_ledPin, on ? HIGH : LOW);
+    _active = on;
+}
+
+void Buzzer::playStepLocked(Output &out)
+{
+    const Step &st = _queue[_cur].steps[_step];
+    out.write = true;
+    out.freq = st.freq;
+    out.volume = st.volume;
+    out.stepUs = uint32_t(st.ms ? st.ms : 1) * 1000u;
+}
+
+void Buzzer::startNextLocked(Output &out)
+{
+    _cur = -1;
+    for (uint8_t i = 0; i < MAX_QUEUE; ++i)
+        if (_queue[i].count && (_cur < 0 || _queue[i].prio > _queue[_cur].prio ||
+                                (_queue[i].prio == _queue[_cur].prio && int32_t(_queue[i].order - _queue[_cur].order) < 0)))
+            _cur = int8_t(i);
+    if (_cur < 0)
+    {
+        out.write = true; // silence
+        return;
+    }
+    _step = 0;
+    playStepLocked(out);
 }
@@ -2,10 +2,33 @@
 #include <Arduino.h>
 #include "esp_timer.h"
 
-// Small helper for beeps/tones using LEDC + a one-shot esp_timer.
+// Small helper for beeps/tones using LEDC + esp_timer.
+// Patterns (tone/silence steps) are sequenced entirely from esp_timer callbacks: a higher
+// priority pattern preempts the one playing, lower ones wait in a short queue, and asking for
+// the pattern that is already playing doesn't restart it (callers may re-trigger every loop).
+// An optional metronome ticks from a periodic esp_timer, e.g. every second of an exposure.
+// Callers only change the sequencer state (under a spinlock) and kick a one-shot timer; LEDC
+// writes and timer arming all happen in the esp_timer task, outside the critical section.
 class Buzzer
 {
 public:
+    struct Step
+    {
+        uint16_t ms = 0;
+        uint16_t freq = 0;   // Hz, 0 = silence
+        uint16_t volume = 0; // 0..2^res-1
+    };
+
+    enum Priority : uint8_t
+    {
+        PRIO_INFO = 0,  // confirmations
+        PRIO_CUE = 1,   // user cues (move card, dodge)
+        PRIO_ALERT = 2, // faults, conflicts
+    };
+
+    static constexpr uint8_t MAX_STEPS = 8;
+    static constexpr uint8_t MAX_QUEUE = 4;
+
     // ledPin is optional: pass -1 if you don't want an indicator LED toggled.
     Buzzer(uint8_t buzzerPin, uint8_t ledcChannel, int8_t ledPin = -1);
 
@@ -14,12 +37,26 @@ public:
     void begin(uint32_t basePwmFreq = 2000, uint8_t resolutionBits = 8);
 
     // Start a tone for tone_ms milliseconds at 'freq' (Hz) and 'volume' (0..2^res-1).
-    // Non-blocking; a one-shot timer will stop it automatically.
-    void buzz(uint16_t tone_ms, uint16_t volume, uint32_t freq);
+    // Non-blocking; a one-step pattern at the given priority.
+    void buzz(uint16_t tone_ms, uint16_t volume, uint32_t freq, Priority prio = PRIO_INFO);
 
-    // Stop any ongoing tone immediately.
+    // Play count steps (copied) repeat times. False if dropped: queue full of equal or higher
+    // priorities. Non-blocking.
+    bool play(const Step *steps, uint8_t count, Priority prio = PRIO_INFO, uint8_t repeat = 1);
+    template <size_t N>
+    bool play(const Step (&steps)[N], Priority prio = PRIO_INFO, uint8_t repeat = 1)
+    {
+        return play(steps, uint8_t(N), prio, repeat);
+    }
+
+    // Stop any ongoing tone and clear the queue (the metronome keeps running).
     void stop();
 
+    // Tick every periodMs for durationMs, the last countdownTicks ticks accented. Ticks only
+    // sound while no pattern plays. Restarts a running metronome.
+    void startMetronome(uint32_t durationMs, uint16_t periodMs = 1000, uint8_t countdownTicks = 3);
+    void stopMetronome();
+
     // Is a tone currently active?
     bool isActive() const { return _active; }
 
@@ -27,12 +64,56 @@ public:
     void setLedPin(int8_t ledPin) { _ledPin = ledPin; }
 
 private:
-    static void timerStopCb(void *arg); // static trampoline for esp_timer
-    void handleStop();                  // instance handler
+    struct Pattern
+    {
+        Step steps[MAX_STEPS];
+        uint8_t count = 0;
+        uint8_t repeat = 0;
+        Priority prio = PRIO_INFO;
+        uint32_t order = 0; // FIFO among equal priorities
+    };
+
+    // Decided under _mux, applied after it by the esp_timer task
+    struct Output
+    {
+        bool write = false; // set freq/volume
+        uint16_t freq = 0;
+        uint16_t volume = 0;
+        uint32_t stepUs = 0;   // re-arm the step timer (0: leave it)
+        bool stopStep = false; // disarm the step timer
+    };
+
+    static void timerKickCb(void *arg); // static trampolines for esp_timer
+    static void timerStepCb(void *arg);
+    static void timerMetroCb(void *arg);
+    void kick();
+    void handleKick();
+    void handleStep();
+    void handleTick();
+    void apply(const Output &out);
+    void writeTone(uint32_t freq, uint16_t volume);
+
+    // Caller holds _mux
+    void playStepLocked(Output &out);
+    void startNextLocked(Output &out);
 
     uint8_t _pin;
     uint8_t _ch;
     int8_t _ledPin;
-    esp_timer_handle_t _timer = nullptr;
-    bool _active = false;
-};
\ No newline at end of file
+    esp_timer_handle_t _kickTimer = nullptr; // callers' changes reach the esp_timer task through it
+    esp_timer_handle_t _timer = nullptr;     // step timer, armed only from the esp_timer task
+    esp_timer_handle_t _metroTimer = nullptr;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED; // sequencer state: callers vs esp_timer task
+    volatile bool _active = false;
+
+    Pattern _queue[MAX_QUEUE];
+    int8_t _cur = -1; // playing queue slot, -1: none
+    uint8_t _step = 0;
+    uint32_t _order = 0;
+    bool _restart = false; // current pattern changed: play its step _step from the kick
+
+    uint32_t _metroTicksLeft = 0;
+    uint8_t _metroCountdown = 0;
+    uint16_t _metroPeriodMs = 0;
+    bool _metroRestart = false; // (re)start or stop the metronome timer from the kick
+};
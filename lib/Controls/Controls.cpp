@@ -1,6 +1,7 @@
 // Controls: implementation
 
 #include "Controls.h"
+#include <Arduino.h>
 #include "GamePad.h"
 #include "TM1638plusWrapper.h"
 
@@ -10,6 +11,16 @@ namespace
   ControlsState s_prevState{}; // snapshot from previous update
   TM1638plusWrapper *tmPanel_ = nullptr;
 
+  // S1-S3 carry single steps and the S2+S3 / S1+S2+S3 chords, which contain each other. The set
+  // held acts only after it is stable for TM_CHORD_SETTLE_MS, and once S2+S3 is part of it
+  // nothing else is taken from S1-S3 until all three are released.
+  constexpr uint32_t TM_CHORD_SETTLE_MS = 80;
+  constexpr uint8_t TM_CHORD_KEYS = TM1638plusWrapper::S1 | TM1638plusWrapper::S2 | TM1638plusWrapper::S3;
+  constexpr uint8_t TM_CHORD_PRESET = TM1638plusWrapper::S2 | TM1638plusWrapper::S3;
+  uint8_t tmChordHeld_ = 0;     // S1-S3 bits currently held
+  uint32_t tmChordSinceMs_ = 0; // when tmChordHeld_ last changed
+  uint8_t tmChordAccepted_ = 0; // the set the timer and chord actions read
+
   struct TMState
   {
     uint8_t raw = 0; // TM1638 buttons
@@ -43,6 +54,23 @@ namespace Controls
     BtInput::begin();
   }
 
+  // Returns the accepted S1-S3 set for this update
+  static uint8_t settleTmChord(const uint8_t rawButtons)
+  {
+    const uint8_t held = rawButtons & TM_CHORD_KEYS;
+    const uint32_t nowMs = millis();
+    if (held != tmChordHeld_)
+    {
+      tmChordHeld_ = held;
+      tmChordSinceMs_ = nowMs;
+    }
+    if (held == 0)
+      tmChordAccepted_ = 0;
+    else if ((tmChordAccepted_ & TM_CHORD_PRESET) != TM_CHORD_PRESET && nowMs - tmChordSinceMs_ >= TM_CHORD_SETTLE_MS)
+      tmChordAccepted_ = held;
+    return tmChordAccepted_;
+  }
+
   static const TMState getTmState(const uint8_t rawButtons)
   {
     TMState tms{};
@@ -65,8 +93,13 @@ namespace Controls
     BtInput::update(); // Update BT state from bluepad32
 
     TMState tmState = {};
+    TMState tmChord = {}; // S1-S3 after settling (timer steps and chords)
     if (tmPanel_ != nullptr)
-      tmState = getTmState(tmPanel_->readButtons());
+    {
+      const uint8_t raw = tmPanel_->readButtons();
+      tmState = getTmState(raw);
+      tmChord = getTmState(settleTmChord(raw));
+    }
 
     const auto &gamePadsState = BtInput::state(); // Aggregate BT state (in case of multiple controllers)
 
@@ -80,8 +113,15 @@ namespace Controls
     s_state.Brightness = gamePadsState.r1;
     s_state.toggleLamp = tmState.S1 && tmState.S8 || gamePadsState.dpadLeft;
     s_state.StartTimer = tmState.S8 && !tmState.S1 || gamePadsState.dpadRight;
-    s_state.increaseTimer = tmState.S3 || gamePadsState.dpadUp;
-    s_state.decreaseTimer = tmState.S2 || gamePadsState.dpadDown;
+    s_state.increaseTimer = tmChord.S3 && !tmChord.S2 || gamePadsState.dpadUp;
+    s_state.decreaseTimer = tmChord.S2 && !tmChord.S3 || gamePadsState.dpadDown;
+    s_state.nextPreset = gamePadsState.select;
+    s_state.goPreset = tmChord.S2 && tmChord.S3 && !tmChord.S1 || gamePadsState.start && !gamePadsState.l1;
+    s_state.savePreset = gamePadsState.start && gamePadsState.l1;
+    s_state.toggleFocusTrack = gamePadsState.thumbR && !gamePadsState.l1;
+    s_state.captureFocus = gamePadsState.thumbR && gamePadsState.l1;
+    s_state.toggleFStop = tmChord.S1 && tmChord.S2 && tmChord.S3 || gamePadsState.system;
+    s_state.cycleExposureMode = gamePadsState.thumbL;
 
     // Build merged buttons mask used for LEDs
 
@@ -21,9 +21,16 @@ struct ControlsState
   bool toggleLamp = false;    // S1+S8 or BT D-pad Left
   bool decreaseTimer = false; // S2 BT D-pad Down
   bool increaseTimer = false; // S3 BT D-pad Up
-
-  // Derived directions (-1,0,+1)
-  int8_t m1Dir = 0; // -1=down, +1=up
+  bool nextPreset = false;    // BT Select
+  bool goPreset = false;      // S2+S3 (without S1) or BT Start
+  bool savePreset = false;    // BT L1+Start
+  bool toggleFocusTrack = false; // BT R3 (right stick press)
+  bool captureFocus = false;     // BT L1+R3 (hold 3 s: clear table)
+  bool toggleFStop = false;      // S1+S2+S3 or BT System (PS): linear / f-stop timer steps
+  bool cycleExposureMode = false; // BT L3 (left stick press): single exposure / test strip
+
+  // Derived directions (-1,0,+1), Down − Up: -1=up (towards home, the upper end stop), +1=down
+  int8_t m1Dir = 0;
   int8_t m2Dir = 0;
 
   // Conflicts
@@ -1,96 +1,494 @@
 #include "DRV8874.h"
 #include "esp32_ledc_compat.h"
+#include "AdcStream.h"
+#include "McpwmPwm.h"
+#include <Preferences.h>
+#include <soc/gpio_struct.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/ledc_periph.h>
+#if __has_include(<esp_rom_gpio.h>)
+#include <esp_rom_gpio.h> // IDF 5.x (Arduino-ESP32 3.x)
+#define DRV8874_GPIO_MATRIX_OUT esp_rom_gpio_connect_out_signal
+#else
+#include <rom/gpio.h> // IDF 4.x (Arduino-ESP32 2.x)
+#define DRV8874_GPIO_MATRIX_OUT gpio_matrix_out
+#endif
 
-void DRV8874::csUpdateTaskEntry(void *arg)
+uint32_t DRV8874::getCurrentmA() const
 {
-    auto *self = static_cast<DRV8874 *>(arg);
+    if (csSlot < 0)
+        return 0;
+    return (AdcStream::readMilliVolts(csSlot) * 1000u) / CS_MV_PER_A;
+}
 
-    const TickType_t period = pdMS_TO_TICKS(1000 / CS_UPDATE_HZ);
-    TickType_t lastWake = xTaskGetTickCount();
+// IN1/IN2 duties: (d, 0) forward, (0, d) reverse, (0, 0) coast, (MAX, MAX) brake
+void DRV8874::writeOutputs(uint32_t dutyIn1, uint32_t dutyIn2)
+{
+#if DRV8874_PWM_BACKEND_MCPWM
+    McpwmPwm::write(pwmSlot, dutyIn1, dutyIn2, MAX_DUTY);
+#elif ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
+    ledcWriteChannel(ch1, dutyIn1);
+    ledcWriteChannel(ch2, dutyIn2);
+#else
+    ledcWrite(ch1, dutyIn1);
+    ledcWrite(ch2, dutyIn2);
+#endif
+}
 
-    for (;;)
+// ROM matrix call and direct register writes only: runs from IRAM with the flash cache disabled.
+// The output level is cleared before the pin leaves LEDC so it never glitches high.
+static inline void IRAM_ATTR pinLowFromIsr(uint8_t pin)
+{
+    if (pin < 32)
+        GPIO.out_w1tc = (1u << pin);
+    else
+        GPIO.out1_w1tc.val = (1u << (pin - 32));
+    DRV8874_GPIO_MATRIX_OUT(pin, SIG_GPIO_OUT_IDX, false, false);
+}
+
+void IRAM_ATTR DRV8874::cutOutputsFromIsr()
+{
+    pinLowFromIsr(in1);
+    pinLowFromIsr(in2);
+    _outputsCut = true;
+}
+
+// Give the pins back to the PWM peripheral. LEDC channels 0-7 are the high-speed group, 8-15 the
+// low-speed group (as esp32-hal-ledc maps them).
+void DRV8874::connectPwm()
+{
+#if DRV8874_PWM_BACKEND_MCPWM
+    DRV8874_GPIO_MATRIX_OUT(in1, McpwmPwm::signal(pwmSlot, 0), false, false);
+    DRV8874_GPIO_MATRIX_OUT(in2, McpwmPwm::signal(pwmSlot, 1), false, false);
+#else
+    DRV8874_GPIO_MATRIX_OUT(in1, ledc_periph_signal[ch1 / 8].sig_out0_idx + (ch1 % 8), false, false);
+    DRV8874_GPIO_MATRIX_OUT(in2, ledc_periph_signal[ch2 / 8].sig_out0_idx + (ch2 % 8), false, false);
+#endif
+}
+
+void DRV8874::reconnectOutputs()
+{
+    post(MotorOp::Reconnect);
+}
+
+// Called by the control task while running in dir past the start window.
+// True once the current stayed above the direction's threshold for holdMs.
+bool DRV8874::stallDetected(int8_t dir)
+{
+    const uint32_t threshold = (dir > 0) ? _stallCfg.thresholdPosmA : _stallCfg.thresholdNegmA;
+    const uint32_t nowMs = millis();
+    if (threshold == 0 || csSlot < 0 || (int32_t)(nowMs - stallBlankUntilMs) < 0 || getCurrentmA() < threshold)
     {
-        uint32_t accRawmV = 0;
-        for (uint16_t i = 0; i < CS_READ_SAMPLES; ++i) // Average CS_READ_SAMPLES into millivolts
-            accRawmV += analogReadMilliVolts(self->csPin);
-        const uint32_t avgRawmV = accRawmV / CS_READ_SAMPLES; // truncate fine as working with mV
-        // Store milli amps (volatile, no heavy sync needed for single writer)
-        self->lastCurrentmA = (avgRawmV * 1000u) / CS_MV_PER_A;
-        vTaskDelayUntil(&lastWake, period);
+        stallSinceMs = 0;
+        return false;
     }
+    if (stallSinceMs == 0)
+        stallSinceMs = nowMs | 1u; // 0 means "not above threshold"
+    return nowMs - stallSinceMs >= _stallCfg.holdMs;
+}
+
+void DRV8874::onCsSample(void *ctx, uint16_t raw)
+{
+    static_cast<DRV8874 *>(ctx)->_ripple.sample(raw);
 }
 
-// Control task: updates duty based on current speedPt and direction values
-//   considers boost duty settings when starting/reversing
+// Attribute the last dtUs of motion with the state that was driven during it (before commands apply)
+void DRV8874::updatePosition(uint32_t dtUs)
+{
+    const int8_t dir = braking ? brakeDir : currentDir;
+    const uint32_t minDuty = dir > 0 ? _minDutyPos : _minDutyNeg;
+    _pos.update(dir, braking ? 0 : dutyCmd, minDuty, MAX_DUTY, _ripple.edges(), rippleFed, dtUs);
+}
+
+// Control task: event driven. Sleeps on a task notification (posted with every command) while
+// idle and ticks at CTRL_UPDATE_HZ only while something is time based (boost, ramp, brake, running).
 void DRV8874::ctrlTaskEntry(void *arg)
 {
     auto *self = static_cast<DRV8874 *>(arg);
     const TickType_t period = pdMS_TO_TICKS(1000 / CTRL_UPDATE_HZ);
-    TickType_t lastWake = xTaskGetTickCount();
+    const uint32_t periodUs = 1000000u / CTRL_UPDATE_HZ;
+    uint32_t lastUs = micros();
 
     for (;;)
     {
-        const int8_t newSpeedPt = self->currentSpeedPt; // snapshot
-        const int8_t newDir = (newSpeedPt == 0) ? 0 : ((newSpeedPt > 0) ? +1 : -1);
-        const uint8_t magPct = (newDir >= 0) ? uint8_t(newSpeedPt) : uint8_t(-newSpeedPt);
-        uint32_t minDuty = (newDir > 0) ? self->_minDutyPos : self->_minDutyNeg;
-        const uint32_t newDutyCmd = (newSpeedPt == 0) ? 0 : map(magPct, 0, 100, minDuty, MAX_DUTY);
+        const uint32_t nowUs = micros();
+        uint32_t dtUs = nowUs - lastUs;
+        lastUs = nowUs;
+        if (dtUs > periodUs) // first tick after idle or a late tick: one nominal step
+            dtUs = periodUs;
 
-        // Detect transition: start from stop OR change of direction
-        uint32_t boosDuty = (newDir > 0) ? START_BOOST_DUTY_POS : START_BOOST_DUTY_NEG;
-        if (newDir != self->currentDir)
+        const bool needsTick = self->controlTick(dtUs);
+        self->publishStatus();
+        ulTaskNotifyTake(pdTRUE, needsTick ? period : portMAX_DELAY);
+    }
+}
+
+// Coast the outputs and drop everything that belongs to a running motor
+void DRV8874::stopOutputs()
+{
+    writeOutputs(0, 0);
+    currentSpeedPt = 0;
+    currentDir = 0;
+    _motion = MotionState{};
+    boostUntilMs = 0;
+    dutyCmd = 0;
+}
+
+// Runs in the control task only: the single owner of the outputs and the control state
+void DRV8874::applyCommand(const MotorCommand &cmd)
+{
+    lastCmdSeq = cmd.seq;
+    if (_cal.active && (cmd.op == MotorOp::Run || cmd.op == MotorOp::Coast || cmd.op == MotorOp::Brake ||
+                        cmd.op == MotorOp::Reconnect))
+    {
+        _cal.active = false; // any motion command takes over
+        stopOutputs();
+        Serial.println("DRV8874: calibration aborted");
+    }
+    switch (cmd.op)
+    {
+    case MotorOp::Run:
+    {
+        int8_t speedPt = cmd.speedPt;
+        const int8_t dir = (speedPt == 0) ? 0 : ((speedPt > 0) ? +1 : -1);
+        if (stallDir != 0 && dir == stallDir)
+            speedPt = 0; // refuse to push further into the end stop until clearStall()
+        else if (dir != 0 && dir == -stallDir)
+            stallDir = 0; // moving away from the end stop
+        currentSpeedPt = speedPt;
+        if (speedPt != 0)
+            braking = false; // run() during the brake window takes over
+        break;
+    }
+    case MotorOp::Coast:
+        braking = false;
+        stopOutputs();
+        break;
+    case MotorOp::Brake:
+        // Timed active brake: brake() only posts it, so callers never block for BREAK_MS
+        brakeDir = braking ? brakeDir : currentDir;
+        stopOutputs();
+        writeOutputs(BREAK_DUTY, BREAK_DUTY);
+        brakeUntilMs = millis() + BREAK_MS;
+        braking = true;
+        break;
+    case MotorOp::ClearStall:
+        stallDir = 0;
+        stallSinceMs = 0;
+        break;
+    case MotorOp::SetPosition:
+        _pos.set(cmd.value);
+        homed = true;
+        break;
+    case MotorOp::Calibrate:
+        braking = false;
+        stopOutputs();
+        if (csSlot < 0)
         {
-            if (newDir == 0 || newDutyCmd >= boosDuty)
-                self->boostUntilMs = 0;
-            else // starting or reversing — enable boost window
-                self->boostUntilMs = millis() + START_BOOST_MS;
+            Serial.println("DRV8874: calibration needs the CS pin");
+            break;
         }
+        _cal = CalState{};
+        _cal.active = true;
+        _cal.slowestPt = (cmd.speedPt > 0 && cmd.speedPt < 100) ? uint8_t(cmd.speedPt) : 10;
+        _cal.dutyQ8 = CAL_START_DUTY << 8;
+        _cal.windowUntilMs = millis() + CAL_RIPPLE_WINDOW_MS;
+        _cal.windowEdges = _ripple.edges();
+        break;
+    case MotorOp::Reconnect:
+        braking = false;
+        stopOutputs(); // LEDC at 0 before it drives the pins again
+        connectPwm();
+        _outputsCut = false;
+        Serial.println("DRV8874: outputs reconnected");
+        break;
+    }
+}
+
+void DRV8874::publishStatus()
+{
+    MotorStatus st;
+    st.dutyCmd = dutyCmd;
+    st.currentmA = getCurrentmA();
+    st.dir = currentDir;
+    st.speedPt = currentSpeedPt;
+    st.stallDir = stallDir;
+    st.state = _cal.active ? MotorState::Calibrating
+               : braking   ? MotorState::Braking
+               : currentDir != 0 ? MotorState::Running
+               : stallDir != 0   ? MotorState::Stalled
+                                 : MotorState::Idle;
+    st.lastCmdSeq = lastCmdSeq;
+    st.position = _pos.position();
+    st.homed = homed;
+    st.rippleLive = _pos.usingRipple();
+    st.minDutyPos = _minDutyPos;
+    st.minDutyNeg = _minDutyNeg;
+    st.calSeq = _calSeq;
+    st.calFound = _calFound;
+    _status.store(st);
+}
+
+// One control step: applies queued commands, then updates duty based on current speedPt and
+//   direction values, considers boost duty settings when starting/reversing.
+// Returns true while another periodic tick is needed.
+bool DRV8874::controlTick(uint32_t dtUs)
+{
+    updatePosition(dtUs);
 
-        // Determine duty to apply (boost only within window)
-        uint32_t appliedDuty = newDutyCmd;
-        if (self->boostUntilMs > 0 && newDir != 0)
+    MotorCommand cmd;
+    while (_cmdQueue.pop(cmd))
+        applyCommand(cmd);
+
+    if (_cal.active)
+        return calibrationTick(dtUs);
+
+    if (braking)
+    {
+        if ((int32_t)(millis() - brakeUntilMs) < 0)
+            return true;
+        writeOutputs(0, 0); // brake window over → coast
+        braking = false;
+    }
+
+    const int8_t targetSpeedPt = currentSpeedPt;
+
+    // Motion profile: ramps starts, speed changes and reversals (through zero).
+    // Stops are immediate: coast()/brake() own those, so a zero target resets the profile.
+    if (targetSpeedPt == 0)
+        _motion = MotionState{};
+    else
+        _motion = MotionProfile::step(_motion, targetSpeedPt, _motionLimits, dtUs);
+
+    const int32_t newSpeedMilliPt = _motion.velMilliPct;
+    const int8_t newDir = (newSpeedMilliPt == 0) ? 0 : ((newSpeedMilliPt > 0) ? +1 : -1);
+    const int32_t magMilliPct = (newDir >= 0) ? newSpeedMilliPt : -newSpeedMilliPt;
+    uint32_t minDuty = (newDir > 0) ? _minDutyPos : _minDutyNeg;
+    const uint32_t newDutyCmd = (newDir == 0) ? 0 : map(magMilliPct, 0, 100 * MotionProfile::MILLI_PCT_PER_PCT, minDuty, MAX_DUTY);
+
+    // Detect transition: start from stop OR change of direction
+    uint32_t boosDuty = (newDir > 0) ? START_BOOST_DUTY_POS : START_BOOST_DUTY_NEG;
+    if (newDir != currentDir)
+    {
+        _speedReg.reset();
+        stallSinceMs = 0;
+        stallBlankUntilMs = millis() + START_BOOST_MS; // ignore inrush current
+        if (newDir == 0 || newDutyCmd >= boosDuty)
+            boostUntilMs = 0;
+        else // starting or reversing — enable boost window
+            boostUntilMs = millis() + START_BOOST_MS;
+    }
+
+    // Determine duty to apply (boost only within window)
+    uint32_t appliedDuty = newDutyCmd;
+    if (boostUntilMs > 0 && newDir != 0)
+    {
+        if (millis() < boostUntilMs)
+            appliedDuty = boosDuty;
+        else // boost window over, working with already set newDutyCmd
+            boostUntilMs = 0;
+    }
+
+    // Closed-loop trim of the open-loop duty (feed-forward) once past start/reverse and boost
+    if (_speedRegCfg.enabled && csPin > 0 && newDir != 0 && newDir == currentDir &&
+        boostUntilMs == 0)
+        appliedDuty = _speedReg.update(_speedRegCfg, newDutyCmd, dutyCmd,
+                                             getCurrentmA(), MAX_DUTY);
+
+    // Stall / end-of-travel: current held above the direction's threshold after the start window
+    if (newDir != 0 && newDir == currentDir && stallDetected(newDir))
+    {
+        stopOutputs(); // coast
+        stallDir = newDir;
+        // End stops are the position references
+        if (newDir < 0 || _posCfg.travelCounts > 0)
         {
-            if (millis() < self->boostUntilMs)
-                appliedDuty = boosDuty;
-            else // boost window over, working with already set newDutyCmd
-                self->boostUntilMs = 0;
+            _pos.set(newDir < 0 ? 0 : _posCfg.travelCounts);
+            homed = true;
         }
+    }
+    // Write new duty only if something changed (dir or applied duty)
+    else if (appliedDuty != dutyCmd || newDir != currentDir)
+    {
+        if (newDir > 0)
+            writeOutputs(appliedDuty, 0);
+        else if (newDir < 0)
+            writeOutputs(0, appliedDuty);
+        else // stopped or profile passing zero on a reversal
+            writeOutputs(0, 0);
 
-        // Write new duty only if something changed (dir or applied duty)
-        if (appliedDuty != self->dutyCmd || newDir != self->currentDir)
-        {
-            if (newDir > 0)
-            {
-#if ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
-                ledcWriteChannel(self->ch1, appliedDuty);
-                ledcWriteChannel(self->ch2, 0);
-#else
-                ledcWrite(self->ch1, appliedDuty);
-                ledcWrite(self->ch2, 0);
-#endif
-            }
-            else if (newDir < 0)
-            {
-#if ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
-                ledcWriteChannel(self->ch1, 0);
-                ledcWriteChannel(self->ch2, appliedDuty);
-#else
-                ledcWrite(self->ch1, 0);
-                ledcWrite(self->ch2, appliedDuty);
-#endif
-            }
-            else // newDir == 0 : actual break in break() or coast() functions , nothing needed here
-                ;
+        dutyCmd = appliedDuty;
+        currentDir = newDir;
+    }
+
+    // Keep ticking while anything is time based or the motor moves (position, stall, regulator);
+    // otherwise sleep until the next command
+    return braking || boostUntilMs != 0 ||
+           !MotionProfile::atTarget(_motion, currentSpeedPt) ||
+           currentDir != 0;
+}
+
+// Calibration sweep step: ramp duty in _cal.dir until breakaway, coast, then the other direction.
+// Breakaway: ripple edges appear (shaft turning) or the stalled-rotor current (rising with duty)
+// drops as back-EMF builds up. Returns true while the sweep runs.
+bool DRV8874::calibrationTick(uint32_t dtUs)
+{
+    const uint32_t nowMs = millis();
+    const uint8_t idx = (_cal.dir > 0) ? 0 : 1;
 
-            self->dutyCmd = appliedDuty;
-            self->currentDir = newDir;
+    if (_cal.pausing)
+    {
+        if ((int32_t)(nowMs - _cal.pauseUntilMs) < 0)
+            return true;
+        _cal.pausing = false;
+        if (_cal.dir < 0)
+        {
+            finishCalibration();
+            return false;
         }
-        vTaskDelayUntil(&lastWake, period);
+        _cal.dir = -1;
+        _cal.dutyQ8 = CAL_START_DUTY << 8;
+        _cal.peakmA = 0;
+        _cal.peakDuty = 0;
+        _cal.windowUntilMs = nowMs + CAL_RIPPLE_WINDOW_MS;
+        _cal.windowEdges = _ripple.edges();
+        return true;
+    }
+
+    _cal.dutyQ8 += uint32_t((uint64_t(CAL_RAMP_DUTY_PER_S) * dtUs * 256u) / 1000000u);
+    const uint32_t duty = _cal.dutyQ8 >> 8;
+    const uint32_t mA = getCurrentmA();
+    if (mA > _cal.peakmA)
+    {
+        _cal.peakmA = mA;
+        _cal.peakDuty = duty;
+    }
+
+    uint32_t breakawayDuty = 0;
+    if (rippleFed && (int32_t)(nowMs - _cal.windowUntilMs) >= 0)
+    {
+        const uint32_t edges = _ripple.edges();
+        if (edges - _cal.windowEdges >= CAL_RIPPLE_EDGES)
+            breakawayDuty = duty;
+        _cal.windowEdges = edges;
+        _cal.windowUntilMs = nowMs + CAL_RIPPLE_WINDOW_MS;
+    }
+    if (!breakawayDuty && _cal.peakmA >= CAL_MIN_PEAK_MA && mA * 100u < _cal.peakmA * (100u - CAL_DROP_PCT))
+        breakawayDuty = _cal.peakDuty;
+
+    const uint32_t stallmA = (_cal.dir > 0) ? _stallCfg.thresholdPosmA : _stallCfg.thresholdNegmA;
+    const bool failed = duty >= MAX_DUTY || (stallmA > 0 && mA >= stallmA); // end stop or no breakaway
+
+    if (breakawayDuty || failed)
+    {
+        _cal.breakaway[idx] = failed ? 0 : breakawayDuty;
+        stopOutputs();
+        _cal.pausing = true;
+        _cal.pauseUntilMs = nowMs + CAL_PAUSE_MS;
+        return true;
+    }
+
+    if (_cal.dir > 0)
+        writeOutputs(duty, 0);
+    else
+        writeOutputs(0, duty);
+    currentDir = _cal.dir; // keeps the position estimate running
+    dutyCmd = duty;
+    return true;
+}
+
+// minDuty so that slowestPt maps to the breakaway duty:
+//   minDuty + (MAX - minDuty) * pt / 100 = breakaway  →  minDuty = (100·breakaway − MAX·pt) / (100 − pt)
+void DRV8874::finishCalibration()
+{
+    _cal.active = false;
+    uint32_t *targets[2] = {&_minDutyPos, &_minDutyNeg};
+    _calFound = 0;
+    for (uint8_t i = 0; i < 2; ++i)
+    {
+        if (_cal.breakaway[i] == 0)
+            continue; // keep the previous value for a failed direction
+        const int32_t pt = _cal.slowestPt;
+        int32_t minDuty = (100 * int32_t(_cal.breakaway[i]) - int32_t(MAX_DUTY) * pt) / (100 - pt);
+        if (minDuty < 0)
+            minDuty = 0;
+        *targets[i] = uint32_t(minDuty);
+        _calFound |= uint8_t(1u << i);
     }
+    ++_calSeq; // published with the next status; saveCalibration() persists it from loop
 }
 
-void DRV8874::begin()
+bool DRV8874::saveCalibration()
 {
+    const MotorStatus st = getStatus();
+    if (st.calSeq == _calSavedSeq)
+        return false;
+    _calSavedSeq = st.calSeq;
+
+    const uint32_t values[2] = {st.minDutyPos, st.minDutyNeg};
+    const char *suffix[2] = {".minP", ".minN"};
+    Preferences prefs;
+    const bool persist = _nvsKey && st.calFound && prefs.begin("drv8874", false);
+    for (uint8_t i = 0; i < 2 && persist; ++i)
+    {
+        if (!(st.calFound & (1u << i)))
+            continue;
+        char key[16];
+        nvsKeyFor(key, suffix[i]);
+        prefs.putUInt(key, values[i]);
+    }
+    if (persist)
+        prefs.end();
+    Serial.printf("DRV8874 %s: calibration done minDutyPos=%lu%s minDutyNeg=%lu%s%s\n", _nvsKey ? _nvsKey : "",
+                  (unsigned long)values[0], (st.calFound & 1u) ? "" : " (failed)", (unsigned long)values[1],
+                  (st.calFound & 2u) ? "" : " (failed)", persist ? " saved" : "");
+    return persist;
+}
+
+void DRV8874::nvsKeyFor(char (&key)[16], const char *suffix) const
+{
+    snprintf(key, sizeof(key), "%s%s", _nvsKey, suffix); // NVS keys: max 15 chars
+}
+
+// Producer side: queue a command for the control task and wake it
+void DRV8874::post(MotorOp op, int8_t speedPt)
+{
+    MotorCommand cmd;
+    cmd.seq = ++cmdSeq;
+    cmd.op = op;
+    cmd.speedPt = speedPt;
+    push(cmd);
+}
+
+void DRV8874::push(const MotorCommand &cmd)
+{
+    if (!_cmdQueue.push(cmd))
+        Serial.println("DRV8874: command queue full, dropped");
+    if (ctrlTaskHandle)
+        xTaskNotifyGive(ctrlTaskHandle);
+}
+
+void DRV8874::begin(const char *nvsKey)
+{
+    _nvsKey = nvsKey;
+    if (_nvsKey)
+    {
+        Preferences prefs;
+        if (prefs.begin("drv8874", false)) // read-write: creates the namespace instead of logging NOT_FOUND
+        {
+            char key[16];
+            nvsKeyFor(key, ".minP");
+            if (prefs.isKey(key))
+                _minDutyPos = prefs.getUInt(key, _minDutyPos);
+            nvsKeyFor(key, ".minN");
+            if (prefs.isKey(key))
+                _minDutyNeg = prefs.getUInt(key, _minDutyNeg);
+            prefs.end();
+            Serial.printf("DRV8874 %s: minDutyPos=%lu minDutyNeg=%lu\n", _nvsKey,
+                          (unsigned long)_minDutyPos, (unsigned long)_minDutyNeg);
+        }
+    }
+
     if (nSLEEP > 0)
     {
         pinMode(nSLEEP, OUTPUT);
@@ -102,8 +500,12 @@ void DRV8874::begin()
     digitalWrite(in1, LOW);
     digitalWrite(in2, LOW);
 
+#if DRV8874_PWM_BACKEND_MCPWM
+    pwmSlot = McpwmPwm::attach(in1, in2, FREQ_HZ); // shared timer: phase aligned with the other motors
+    if (pwmSlot < 0)
+        Serial.println("DRV8874: MCPWM attach failed, outputs stay low");
     // LEDC: support both Arduino-ESP32 v3.x and older 2.x APIs
-#if ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
+#elif ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
     ledcAttachChannel(in1, FREQ_HZ, PWM_RES_BITS, ch1);
     ledcAttachChannel(in2, FREQ_HZ, PWM_RES_BITS, ch2);
 #else
@@ -113,24 +515,23 @@ void DRV8874::begin()
     ledcAttachPin(in2, ch2);
 #endif
 
-    coast();
+    stopOutputs(); // control task doesn't exist yet: coast directly
+    publishStatus();
 
     constexpr BaseType_t CORE_APP = 1; // core-1
-    constexpr UBaseType_t PRIO_CS = tskIDLE_PRIORITY + 1;
-    constexpr UBaseType_t PRIO_CTRL = tskIDLE_PRIORITY + 2; // higher than CS
+    constexpr UBaseType_t PRIO_CTRL = tskIDLE_PRIORITY + 2; // below the AdcStream reader
 
     if (csPin > 0)
     {
         pinMode(csPin, INPUT);
-        // Channel will be initialized on first analogRead; attenuation is set
-        // globally in setup() via analogSetAttenuation(CS_ADC_ATTENUATION).
-
-        // CS updater task (runs at CS_UPDATE_HZ)
-        xTaskCreatePinnedToCore(csUpdateTaskEntry, "drv8874_cs",
-                                2048, this, PRIO_CS, &csUpdateTaskHandle, CORE_APP);
+        // Shared sampler for all motors' CS pins; (re)starts with this pin added
+        csSlot = AdcStream::attach(csPin);
+        _ripple.configure(_posCfg.ripple);
+        rippleFed = AdcStream::setSampleSink(csSlot, &DRV8874::onCsSample, this);
     }
+    _pos.configure(_posCfg);
 
-    // Control task (runs at CTRL_UPDATE_HZ)
+    // Control task (event driven, CTRL_UPDATE_HZ while active)
     xTaskCreatePinnedToCore(ctrlTaskEntry, "drv8874_ctrl",
                             3072, this, PRIO_CTRL, &ctrlTaskHandle, CORE_APP);
 
@@ -143,42 +544,45 @@ void DRV8874::run(int8_t speedPt)
         speedPt = 100;
     else if (speedPt < -100)
         speedPt = -100;
-    currentSpeedPt = speedPt;
+
+    cmdSpeedPt = speedPt;
+    post(MotorOp::Run, speedPt);
 }
 
 void DRV8874::coast()
 {
-#if ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
-    ledcWriteChannel(ch1, 0);
-    ledcWriteChannel(ch2, 0);
-#else
-    ledcWrite(ch1, 0);
-    ledcWrite(ch2, 0);
-#endif
-    currentDir = 0;
-    currentSpeedPt = 0;
-    boostUntilMs = 0;
-    dutyCmd = 0;
+    cmdSpeedPt = 0;
+    post(MotorOp::Coast);
     Serial.println("coast");
 }
 
 void DRV8874::brake()
 {
+    // Control task applies BREAK_DUTY on both inputs for BREAK_MS, then coasts
+    cmdSpeedPt = 0;
+    post(MotorOp::Brake);
+    Serial.println("BREAK");
+}
 
-#if ARDUINO_ESP32_HAS_LEDC_ATTACH_CHANNEL
-    ledcWriteChannel(ch1, BREAK_DUTY);
-    ledcWriteChannel(ch2, BREAK_DUTY);
-#else
-    ledcWrite(ch1, BREAK_DUTY);
-    ledcWrite(ch2, BREAK_DUTY);
-#endif
+void DRV8874::clearStall()
+{
+    post(MotorOp::ClearStall);
+}
 
-    currentDir = 0;
-    currentSpeedPt = 0;
-    Serial.println("BREAK");
+void DRV8874::calibrate(uint8_t slowestPt)
+{
+    cmdSpeedPt = 0;
+    post(MotorOp::Calibrate, int8_t(slowestPt));
+    Serial.println("calibrate");
+}
 
-    delay(BREAK_MS);
-    coast();
+void DRV8874::setPosition(int32_t position)
+{
+    MotorCommand cmd;
+    cmd.seq = ++cmdSeq;
+    cmd.op = MotorOp::SetPosition;
+    cmd.value = position;
+    push(cmd);
 }
 
 void DRV8874::sleep()
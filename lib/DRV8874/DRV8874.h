@@ -1,5 +1,9 @@
 #pragma once
 #include <Arduino.h>
+#include "SpeedRegulator.h"
+#include "MotionProfile.h"
+#include "MotorMailbox.h"
+#include "PositionEstimator.h"
 
 // ========= Duty ctrl  params =========
 static constexpr uint8_t PWM_RES_BITS = 10;
@@ -14,24 +18,41 @@ static constexpr uint32_t START_BOOST_DUTY_POS = MAX_DUTY / 2u;
 static constexpr uint32_t START_BOOST_DUTY_NEG = MAX_DUTY / 2u;
 static constexpr uint32_t START_BOOST_MS = 40;
 
-static constexpr uint16_t CTRL_UPDATE_HZ = 500; // Duty control task run freq
+// Min-duty calibration sweep (calibrate()): duty ramps from CAL_START_DUTY until breakaway
+static constexpr uint32_t CAL_START_DUTY = MAX_DUTY / 4u;
+static constexpr uint32_t CAL_RAMP_DUTY_PER_S = 150;  // ~4 s to full duty
+static constexpr uint16_t CAL_RIPPLE_WINDOW_MS = 50;  // breakaway: ripple edges within one window...
+static constexpr uint8_t CAL_RIPPLE_EDGES = 3;        // ...at least this many
+static constexpr uint32_t CAL_MIN_PEAK_MA = 80;       // breakaway: current fell CAL_DROP_PCT below a peak of at least this
+static constexpr uint8_t CAL_DROP_PCT = 15;
+static constexpr uint16_t CAL_PAUSE_MS = 400;         // coast between directions
+
+static constexpr uint16_t CTRL_UPDATE_HZ = 500; // Duty control task tick freq while active (idle: sleeps until a command)
 
 // ========= Current sense  params for current sense voltage-to-current readings =========
-static constexpr uint16_t CS_UPDATE_HZ = 100;  // How often we refresh the averaged current reading. e.g. 100 Hz → every 10 ms
-static constexpr uint16_t CS_READ_SAMPLES = 8; // How many raw ADC samples to average per update
-constexpr float CS_VREF = 3.30f;               // should calibrate and tune together with attenuation
-constexpr adc_attenuation_t CS_ADC_ATTENUATION = ADC_11db;
+// CS pins are sampled by the shared AdcStream engine (continuous DMA ADC, 11/12 dB attenuation,
+// calibrated mV, ~625 Hz filtered updates). See AdcStream.h for rates and filtering.
 constexpr uint32_t CS_MV_PER_A = 1133; // mV per 1 A motor current (R=2.49kΩ on CS in DRV8874 pololu carrier)
 // No divider resistor  on CS pin as current limited via VREF top <2A so CS < 3.3V
 // For higher current limits add a divider and update CS_MV_PER_A
 
+// Stall / end-of-travel detection on the CS current. A threshold of 0 disables that direction.
+// Running current above the threshold for holdMs (after the start/boost window) coasts the motor.
+struct StallDetectConfig
+{
+    uint32_t thresholdPosmA = 0;
+    uint32_t thresholdNegmA = 0;
+    uint16_t holdMs = 6;
+};
+
 class DRV8874
 {
 public:
     // in1Pin/in2Pin: logic inputs to the driver
     // csPin: current sense input, pass 0 if not used. Note: works on ADC1 pins; ADC2 behavior depends on WiFi usage.
     // sleepPin: nSLEEP (active HIGH). If you hard-tied nSLEEP HIGH, pass 0.
-    // chIn1/chIn2: LEDC PWM channels (distinct per channel and motor)
+    // chIn1/chIn2: LEDC PWM channels (distinct per channel and motor); unused with the MCPWM backend
+    //    (build flag DRV8874_PWM_BACKEND_MCPWM=1, see McpwmPwm.h)
     // minDutyPos/minDutyNeg: minimum duty for positive/negative speeds to map speedPt to actual Duty.
     //    option for different values per direction for asymmetric duty ranges.
     DRV8874(uint8_t in1Pin, uint8_t in2Pin, uint8_t csPin, uint8_t sleepPin,
@@ -41,15 +62,22 @@ public:
           ch1(chIn1), ch2(chIn2),
           _minDutyPos(minDutyPos), _minDutyNeg(minDutyNeg) {}
 
-    void begin();
+    // nvsKey: short per-motor name (e.g. "m1") to load/store calibrated min duties in Preferences
+    //   namespace "drv8874". nullptr: no persistence, constructor values only.
+    void begin(const char *nvsKey = nullptr);
+
+    // Commands below are posted to the control task through a lock-free queue and return at once.
+    // Call them from a single task (loop); status getters are safe from any task.
 
     // Signed speed: % of _max_duty (-100..+100). START_BOOST_DUTY for START_BOOST_MS
+    // Speed changes and reversals follow the motion limits (see setMotionLimits)
     void run(int8_t speedPt);
 
     // High-impedance (coast): IN1=0, IN2=0
     void coast();
 
-    // Active brake (low-side slow-decay): IN1=1, IN2=1 , BREAK_DUTY for BREAK_MS
+    // Active brake (low-side slow-decay): IN1=1, IN2=1 , BREAK_DUTY for BREAK_MS, then coast.
+    // Non-blocking: the control task times the brake window. run() during the window cancels it.
     void brake();
 
     // Put driver into low-power sleep (nSLEEP=LOW).
@@ -60,38 +88,149 @@ public:
 
     uint32_t getMaxDuty() const { return MAX_DUTY; }
 
-    // Getter for current direction
-    int8_t getDirection() const { return currentDir; }
+    // Consistent snapshot of duty, direction, current and state published by the control task
+    MotorStatus getStatus() const { return _status.load(); }
 
-    // Getter for current speed % (-100...+100)
-    int8_t getSpeed() const { return currentSpeedPt; }
-
-    // returns last measured current on CS pin in milli Amps. returns 0 if CS pin was set to -1
-    uint32_t getCurrentmA() const { return lastCurrentmA; }
-
-    uint32_t getDutyCmd() const { return dutyCmd; }
+    // Getter for current direction
+    int8_t getDirection() const { return getStatus().dir; }
+
+    // Last commanded speed % (-100...+100) as passed to run() (0 after coast/brake)
+    int8_t getSpeed() const { return cmdSpeedPt; }
+
+    // returns last measured current on CS pin in milli Amps. returns 0 if CS pin was set to 0
+    uint32_t getCurrentmA() const;
+
+    uint32_t getDutyCmd() const { return getStatus().dutyCmd; }
+
+    bool isBraking() const { return getStatus().state == MotorState::Braking; }
+
+    // Stall detection (needs csPin). After a stall the motor is coasted and run() refuses that
+    // direction until clearStall() or a run() in the opposite direction.
+    void setStallDetection(const StallDetectConfig &cfg) { _stallCfg = cfg; }
+    bool isStalled() const { return getStatus().stallDir != 0; }
+    int8_t getStallDirection() const { return getStatus().stallDir; }
+    void clearStall();
+
+    // Sensorless position in ripple counts: commutation ripple in the CS current (continuous ADC),
+    // duty × time fallback. Negative is up: a stall in the negative direction (the upper end stop,
+    // home) re-zeroes it; a stall in the positive direction (lower end stop) sets it to
+    // travelCounts if known. Set the config before begin().
+    void setPositionConfig(const PositionConfig &cfg) { _posCfg = cfg; }
+    const PositionConfig &getPositionConfig() const { return _posCfg; }
+    int32_t getPosition() const { return getStatus().position; }
+    bool isHomed() const { return getStatus().homed; }
+    void setPosition(int32_t position); // e.g. manual zero; marks the position homed
+
+    // Min-duty calibration: slowly ramps duty in each direction (positive first), detects breakaway
+    // from ripple edges or the current peak dropping, and sets minDutyPos/minDutyNeg so slowestPt
+    // maps to the breakaway duty. Needs csPin; any run/coast/brake aborts it.
+    void calibrate(uint8_t slowestPt);
+    bool isCalibrating() const { return getStatus().state == MotorState::Calibrating; }
+    uint32_t getMinDutyPos() const { return getStatus().minDutyPos; }
+    uint32_t getMinDutyNeg() const { return getStatus().minDutyNeg; }
+    // Call from loop(): stores the result of a finished sweep under nvsKey, so the flash write
+    // never stalls the control task. True if something was written.
+    bool saveCalibration();
+
+    // Acceleration / jerk limits applied by the control task. Default 0 = jump to target speed.
+    void setMotionLimits(const MotionLimits &limits) { _motionLimits = limits; }
+    const MotionLimits &getMotionLimits() const { return _motionLimits; }
+
+    // Optional closed-loop speed regulation from the CS current (needs csPin). Disabled by default.
+    void setSpeedRegulator(const SpeedRegulatorConfig &cfg) { _speedRegCfg = cfg; }
+    const SpeedRegulatorConfig &getSpeedRegulator() const { return _speedRegCfg; }
+
+    // Fault cut-off, safe from an ISR (IRAM): routes IN1/IN2 away from LEDC in the GPIO matrix and
+    // drives them low (coast) with two register writes. The control task keeps running but can no
+    // longer reach the pins until reconnectOutputs(), which coasts first and then reroutes LEDC.
+    void IRAM_ATTR cutOutputsFromIsr();
+    void reconnectOutputs();
+    bool isOutputCut() const { return _outputsCut; }
 
 private:
     uint8_t in1, in2, csPin, nSLEEP;
     uint8_t ch1, ch2;
-    int8_t currentDir;     // +1 forward, -1 reverse, 0 stopped
-    int8_t currentSpeedPt; // 0 to 100 percent
-    uint32_t _minDutyPos;
+    uint32_t _minDutyPos; // written by the control task after calibration
     uint32_t _minDutyNeg;
+    const char *_nvsKey = nullptr;
+
+    // ======== Command / status channel ========
+    // Producer side (caller of run/coast/brake)
+    int8_t cmdSpeedPt = 0;
+    uint16_t cmdSeq = 0;
+    SpscQueue<MotorCommand, 8> _cmdQueue;
+    void post(MotorOp op, int8_t speedPt = 0);
+    void push(const MotorCommand &cmd);
+    // Consumer → readers
+    SeqLock<MotorStatus> _status;
 
-    // ======== CS updater  ========
-    // Updater State
-    volatile uint32_t lastCurrentmA = 0u; // updated by FreeRTOS task if CS pin is set
-    // Updater task
-    TaskHandle_t csUpdateTaskHandle = nullptr; // CS updater task handle
-    static void csUpdateTaskEntry(void *arg);
+    // ======== CS  ========
+    int8_t csSlot = -1; // AdcStream slot of csPin, -1 if not used
 
     // ======== Current-based duty control  ========
-    // ControlState
+    // ControlState: owned by the control task
+    int8_t currentDir = 0;     // +1 forward, -1 reverse, 0 stopped
+    int8_t currentSpeedPt = 0; // setpoint -100 to 100 percent
+    uint16_t lastCmdSeq = 0;
     uint32_t dutyCmd = 0;      // persisted duty command (0..MAX_DUTY)
     uint32_t boostUntilMs = 0; // set to millis() + START_BOOST_MS on start/reverse
+    bool braking = false;      // brake window active
+    uint32_t brakeUntilMs = 0;
+    MotionLimits _motionLimits;
+    MotionState _motion;       // profiled speed
+    SpeedRegulatorConfig _speedRegCfg;
+    SpeedRegulator _speedReg;
+
+    // Stall detection state
+    StallDetectConfig _stallCfg;
+    int8_t stallDir = 0;             // direction the motor stalled in, 0 = none
+    uint32_t stallSinceMs = 0;       // first tick above threshold, 0 = below
+    uint32_t stallBlankUntilMs = 0;  // ignore inrush after start/reverse
+    bool stallDetected(int8_t dir);
+
+    // Calibration sweep (control task)
+    struct CalState
+    {
+        bool active = false;
+        bool pausing = false;    // coasting between directions
+        int8_t dir = +1;
+        uint8_t slowestPt = 10;
+        uint32_t dutyQ8 = 0;     // ramped duty, Q8 for sub-count steps per tick
+        uint32_t peakmA = 0;
+        uint32_t peakDuty = 0;
+        uint32_t windowEdges = 0;
+        uint32_t windowUntilMs = 0;
+        uint32_t pauseUntilMs = 0;
+        uint32_t breakaway[2] = {0, 0}; // [0] positive, [1] negative; 0 = not found
+    };
+    CalState _cal;
+    uint8_t _calSeq = 0;      // control task: finished sweeps
+    uint8_t _calFound = 0;
+    uint8_t _calSavedSeq = 0; // loop: last sweep handled by saveCalibration()
+    bool calibrationTick(uint32_t dtUs);
+    void finishCalibration();
+    void nvsKeyFor(char (&key)[16], const char *suffix) const;
+
+    // Position estimate (control task) fed by the ripple counter (AdcStream reader task)
+    PositionConfig _posCfg;
+    PositionEstimator _pos;
+    RippleCounter _ripple;
+    bool rippleFed = false;
+    bool homed = false;
+    int8_t brakeDir = 0; // direction before the brake: ripple while braking still moves the load
+    static void onCsSample(void *ctx, uint16_t raw);
+    void updatePosition(uint32_t dtUs);
+
+    int8_t pwmSlot = -1; // McpwmPwm slot (DRV8874_PWM_BACKEND_MCPWM only)
+    void writeOutputs(uint32_t dutyIn1, uint32_t dutyIn2);
+    void connectPwm();
+    volatile bool _outputsCut = false; // set by cutOutputsFromIsr(), cleared by the control task
 
     // Control task
     TaskHandle_t ctrlTaskHandle = nullptr;
     static void ctrlTaskEntry(void *arg);
-};
\ No newline at end of file
+    bool controlTick(uint32_t dtUs);
+    void applyCommand(const MotorCommand &cmd);
+    void stopOutputs(); // coast outputs and reset the running state
+    void publishStatus();
+};
@@ -0,0 +1,59 @@
+// Host-side plant model of a brushed DC motor driven by a DRV8874 in PWM (IN/IN) mode.
+// Averaged-PWM electrical model (R, L, back-EMF) plus a rigid mechanical model with a
+// constant load torque (spring / gravity) and friction. Used to check SpeedRegulator gains
+// and step responses without hardware; not compiled into the firmware.
+
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+struct DcMotorModel
+{
+    // Parameters (defaults roughly match a small 12 V gear motor)
+    float supplyV = 12.0f;
+    float resistanceOhm = 4.0f;
+    float inductanceH = 0.002f;
+    float kePerRadS = 0.02f;   // back-EMF constant V/(rad/s), equals torque constant Nm/A
+    float inertia = 2.0e-6f;   // kg*m^2 at the motor shaft
+    float viscous = 2.0e-6f;   // Nm/(rad/s)
+    float coulombNm = 0.002f;  // static/dynamic friction magnitude
+    float loadNm = 0.0f;       // signed external load torque (e.g. spring pulling the column)
+
+    // State
+    float currentA = 0.0f;
+    float speedRadS = 0.0f;
+
+    // Advance the model by dtS with signed duty (-1..+1). Internally sub-steps for stability.
+    void step(float dutySigned, float dtS)
+    {
+        constexpr float SUB_DT = 20e-6f;
+        int n = (int)ceilf(dtS / SUB_DT);
+        if (n < 1)
+            n = 1;
+        const float h = dtS / n;
+        for (int i = 0; i < n; ++i)
+        {
+            const float v = dutySigned * supplyV;
+            const float dI = (v - resistanceOhm * currentA - kePerRadS * speedRadS) / inductanceH;
+            currentA += dI * h;
+
+            const float drive = kePerRadS * currentA - loadNm - viscous * speedRadS;
+            if (speedRadS == 0.0f && fabsf(drive) <= coulombNm)
+                continue; // stuck by static friction
+            const float friction = (speedRadS != 0.0f) ? copysignf(coulombNm, speedRadS) : copysignf(coulombNm, drive);
+            const float prev = speedRadS;
+            speedRadS += (drive - friction) / inertia * h;
+            if ((prev > 0.0f && speedRadS < 0.0f) || (prev < 0.0f && speedRadS > 0.0f))
+                speedRadS = 0.0f; // friction can stop the shaft, never reverse it
+        }
+    }
+
+    // What the DRV8874 CS pin reports: current magnitude in mA
+    uint32_t currentmA() const { return (uint32_t)(fabsf(currentA) * 1000.0f + 0.5f); }
+
+    // Convenience for duty counts as used by DRV8874 (0..maxDuty, dir -1/0/+1)
+    void stepDuty(uint32_t duty, int8_t dir, uint32_t maxDuty, float dtS)
+    {
+        step(dir * (float)duty / (float)maxDuty, dtS);
+    }
+};
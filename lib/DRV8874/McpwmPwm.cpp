@@ -0,0 +1,163 @@
+// McpwmPwm: implementation (compiled to nothing unless DRV8874_PWM_BACKEND_MCPWM)
+
+#include "McpwmPwm.h"
+
+#if DRV8874_PWM_BACKEND_MCPWM
+
+#if !__has_include(<driver/mcpwm_prelude.h>)
+#error "DRV8874_PWM_BACKEND_MCPWM needs ESP-IDF 5 (Arduino-ESP32 3.x)"
+#endif
+
+#include <Arduino.h>
+#include <driver/mcpwm_prelude.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/gpio_struct.h>
+#include <soc/mcpwm_periph.h>
+#include <soc/soc_caps.h>
+
+namespace
+{
+  constexpr int GROUP = 0;
+  constexpr uint32_t TIMER_RESOLUTION_HZ = 40000000; // 40 MHz: 1000 compare steps at 20 kHz up-down
+
+  struct Slot
+  {
+    mcpwm_oper_handle_t oper = nullptr;
+    mcpwm_cmpr_handle_t cmp[2] = {nullptr, nullptr};
+    mcpwm_gen_handle_t gen[2] = {nullptr, nullptr};
+    int sig[2] = {-1, -1};     // GPIO matrix output signal of each generator (IN1, IN2)
+    int8_t forced[2] = {0, 0}; // current force level, -1 = PWM
+    uint32_t ticks[2] = {0, 0};
+  };
+
+  mcpwm_timer_handle_t s_timer = nullptr;
+  uint32_t s_peakTicks = 0; // up-down: counts 0 → peak → 0 per PWM period
+  Slot s_slots[McpwmPwm::MAX_MOTORS];
+  uint8_t s_count = 0;
+
+  bool ensureTimer(uint32_t freqHz)
+  {
+    if (s_timer)
+      return true;
+    mcpwm_timer_config_t cfg = {};
+    cfg.group_id = GROUP;
+    cfg.clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT;
+    cfg.resolution_hz = TIMER_RESOLUTION_HZ;
+    cfg.count_mode = MCPWM_TIMER_COUNT_MODE_UP_DOWN;
+    cfg.period_ticks = (TIMER_RESOLUTION_HZ / freqHz) & ~1u; // full up-down period, even
+    if (mcpwm_new_timer(&cfg, &s_timer) != ESP_OK)
+    {
+      s_timer = nullptr;
+      return false;
+    }
+    s_peakTicks = cfg.period_ticks / 2;
+    mcpwm_timer_enable(s_timer);
+    mcpwm_timer_start_stop(s_timer, MCPWM_TIMER_START_NO_STOP);
+    return true;
+  }
+
+  // Output signal the driver routed to pin, read back from the GPIO matrix and checked against
+  // the group's generator signals: nothing depends on the order operators are handed out in
+  int routedSignal(uint8_t pin)
+  {
+    const int sig = GPIO.func_out_sel_cfg[pin].func_sel;
+    for (int op = 0; op < SOC_MCPWM_OPERATORS_PER_GROUP; ++op)
+      for (int g = 0; g < SOC_MCPWM_GENERATORS_PER_OPERATOR; ++g)
+        if (mcpwm_periph_signals.groups[GROUP].operators[op].generators[g].pwm_sig == sig)
+          return sig;
+    return -1;
+  }
+
+  // High while the counter is below the compare value: centred on the timer zero
+  bool addGenerator(Slot &s, uint8_t i, uint8_t pin)
+  {
+    mcpwm_comparator_config_t cmpCfg = {};
+    cmpCfg.flags.update_cmp_on_tez = true;
+    mcpwm_generator_config_t genCfg = {};
+    genCfg.gen_gpio_num = pin;
+    if (mcpwm_new_comparator(s.oper, &cmpCfg, &s.cmp[i]) != ESP_OK ||
+        mcpwm_new_generator(s.oper, &genCfg, &s.gen[i]) != ESP_OK)
+      return false;
+    s.sig[i] = routedSignal(pin);
+    if (s.sig[i] < 0)
+      return false;
+    mcpwm_comparator_set_compare_value(s.cmp[i], 0);
+    mcpwm_generator_set_action_on_compare_event(
+        s.gen[i], MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, s.cmp[i], MCPWM_GEN_ACTION_LOW));
+    mcpwm_generator_set_action_on_compare_event(
+        s.gen[i], MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_DOWN, s.cmp[i], MCPWM_GEN_ACTION_HIGH));
+    mcpwm_generator_set_force_level(s.gen[i], 0, true);
+    s.forced[i] = 0;
+    return true;
+  }
+
+  void setOne(Slot &s, uint8_t i, uint32_t duty, uint32_t maxDuty)
+  {
+    const int8_t force = duty == 0 ? 0 : (duty >= maxDuty ? 1 : -1);
+    if (force < 0)
+    {
+      uint32_t ticks = (duty * s_peakTicks) / maxDuty;
+      if (ticks < 1)
+        ticks = 1;
+      else if (ticks > s_peakTicks - 1)
+        ticks = s_peakTicks - 1;
+      if (ticks != s.ticks[i])
+      {
+        mcpwm_comparator_set_compare_value(s.cmp[i], ticks); // latched at the next timer zero
+        s.ticks[i] = ticks;
+      }
+    }
+    if (force != s.forced[i])
+    {
+      mcpwm_generator_set_force_level(s.gen[i], force, true);
+      s.forced[i] = force;
+    }
+  }
+} // namespace
+
+namespace McpwmPwm
+{
+  int8_t attach(uint8_t in1, uint8_t in2, uint32_t freqHz)
+  {
+    if (s_count >= MAX_MOTORS || !ensureTimer(freqHz))
+      return -1;
+    Slot &s = s_slots[s_count];
+    mcpwm_operator_config_t operCfg = {};
+    operCfg.group_id = GROUP;
+    if (mcpwm_new_operator(&operCfg, &s.oper) != ESP_OK || mcpwm_operator_connect_timer(s.oper, s_timer) != ESP_OK ||
+        !addGenerator(s, 0, in1) || !addGenerator(s, 1, in2))
+    {
+      Serial.println("McpwmPwm: operator setup failed");
+      return -1;
+    }
+    return int8_t(s_count++);
+  }
+
+  void write(int8_t slot, uint32_t dutyIn1, uint32_t dutyIn2, uint32_t maxDuty)
+  {
+    if (slot < 0 || slot >= s_count)
+      return;
+    Slot &s = s_slots[slot];
+    // Lower the falling input first: a period boundary between the two writes then shows
+    // (0, 0) coast on a reversal, never both inputs high
+    if (dutyIn1 < dutyIn2)
+    {
+      setOne(s, 0, dutyIn1, maxDuty);
+      setOne(s, 1, dutyIn2, maxDuty);
+    }
+    else
+    {
+      setOne(s, 1, dutyIn2, maxDuty);
+      setOne(s, 0, dutyIn1, maxDuty);
+    }
+  }
+
+  int signal(int8_t slot, uint8_t gen)
+  {
+    if (slot < 0 || slot >= s_count || gen > 1)
+      return SIG_GPIO_OUT_IDX; // plain GPIO: the pin stays at the level the cut left it
+    return s_slots[slot].sig[gen];
+  }
+} // namespace McpwmPwm
+
+#endif // DRV8874_PWM_BACKEND_MCPWM
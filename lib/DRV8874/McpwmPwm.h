@@ -0,0 +1,30 @@
+// McpwmPwm: optional DRV8874 output backend on MCPWM group 0 (build flag DRV8874_PWM_BACKEND_MCPWM=1,
+// ESP-IDF 5 / Arduino-ESP32 3.x only). All motors share one up-down timer, so their PWM is
+// centre aligned and phase locked. Each motor is one operator: IN1/IN2 are its two generators, high
+// around the timer zero for `duty` of the period. Compare values latch at the timer zero, so a
+// duty change applies whole at a period boundary. Duty 0 and full duty (coast / brake) are
+// forced levels and apply at once. Frees the LEDC channels for the buzzer and others.
+// The ESP32 ADC cannot be triggered by MCPWM; current sensing stays on the free-running AdcStream.
+
+#pragma once
+#include <stdint.h>
+
+#ifndef DRV8874_PWM_BACKEND_MCPWM
+#define DRV8874_PWM_BACKEND_MCPWM 0
+#endif
+
+namespace McpwmPwm
+{
+  constexpr uint8_t MAX_MOTORS = 3; // operators per MCPWM group
+
+  // Create (first call: also the shared timer) an operator driving in1/in2 at freqHz.
+  // Returns the slot for write() or -1 on failure. Outputs start low.
+  int8_t attach(uint8_t in1, uint8_t in2, uint32_t freqHz);
+
+  // Duties in 0..maxDuty. Control task only (one writer per slot).
+  void write(int8_t slot, uint32_t dutyIn1, uint32_t dutyIn2, uint32_t maxDuty);
+
+  // GPIO matrix output signal of a generator (0: IN1, 1: IN2), to reroute a pin after a fault cut.
+  // Recorded per slot when the generator is created.
+  int signal(int8_t slot, uint8_t gen);
+} // namespace McpwmPwm
@@ -0,0 +1,86 @@
+// Acceleration / jerk limited speed profile (trapezoidal or S-curve) for DRV8874::run().
+// The control task advances the profile every tick toward the commanded speed.
+
+#pragma once
+#include <stdint.h>
+
+// Per-motor limits in speed % units. 0 = unlimited.
+//  accelPctPerS only: trapezoidal ramp
+//  accelPctPerS + jerkPctPerS2: S-curve (acceleration itself ramps)
+struct MotionLimits
+{
+    uint32_t accelPctPerS = 0;
+    uint32_t jerkPctPerS2 = 0;
+};
+
+// Profile state in milli-percent (±100000 = ±100 %) for sub-percent resolution at 500 Hz
+struct MotionState
+{
+    int32_t velMilliPct = 0;
+    int32_t accMilliPctPerS = 0;
+};
+
+namespace MotionProfile
+{
+    constexpr int32_t MILLI_PCT_PER_PCT = 1000;
+
+    inline int32_t clampAbs(int32_t v, int32_t lim) { return v > lim ? lim : (v < -lim ? -lim : v); }
+
+    // Advance one tick of dtUs toward targetPct (-100..+100). Never overshoots the target.
+    inline MotionState step(MotionState s, int8_t targetPct, const MotionLimits &lim, uint32_t dtUs)
+    {
+        const int32_t target = int32_t(targetPct) * MILLI_PCT_PER_PCT;
+        if (lim.accelPctPerS == 0)
+            return MotionState{target, 0};
+
+        const int32_t aMax = int32_t(lim.accelPctPerS) * MILLI_PCT_PER_PCT;
+        const int32_t dv = target - s.velMilliPct;
+        if (dv == 0 && s.accMilliPctPerS == 0)
+            return s;
+
+        if (lim.jerkPctPerS2 == 0) // trapezoidal: constant acceleration until target
+        {
+            int32_t dvMax = int32_t((int64_t(aMax) * dtUs) / 1000000);
+            if (dvMax < 1)
+                dvMax = 1;
+            const int32_t stepV = clampAbs(dv, dvMax);
+            s.velMilliPct += stepV;
+            s.accMilliPctPerS = (s.velMilliPct == target) ? 0 : (dv > 0 ? aMax : -aMax);
+            return s;
+        }
+
+        // S-curve: pick the acceleration we steer toward so that ramping acceleration back to
+        // zero (at jMax) lands exactly on the target velocity.
+        const int64_t jMax = int64_t(lim.jerkPctPerS2) * MILLI_PCT_PER_PCT;
+        int32_t daMax = int32_t((jMax * dtUs) / 1000000);
+        if (daMax < 1)
+            daMax = 1;
+        const int64_t a = s.accMilliPctPerS;
+        const int64_t dvToZeroAcc = (a * (a < 0 ? -a : a)) / (2 * jMax); // velocity gained while unwinding a
+        const int64_t remaining = int64_t(dv) - dvToZeroAcc;
+        const int32_t aimAcc = remaining > 0 ? aMax : (remaining < 0 ? -aMax : 0);
+
+        s.accMilliPctPerS = clampAbs(s.accMilliPctPerS + clampAbs(aimAcc - s.accMilliPctPerS, daMax), aMax);
+        int32_t stepV = int32_t((int64_t(s.accMilliPctPerS) * dtUs) / 1000000);
+        if (stepV == 0 && s.accMilliPctPerS != 0)
+            stepV = s.accMilliPctPerS > 0 ? 1 : -1;
+        s.velMilliPct += stepV;
+
+        // Snap when crossing the target or when close and the acceleration is nearly unwound
+        const int32_t dvAfter = target - s.velMilliPct;
+        const bool crossed = (dv > 0 && dvAfter <= 0) || (dv < 0 && dvAfter >= 0);
+        const int32_t absAcc = s.accMilliPctPerS < 0 ? -s.accMilliPctPerS : s.accMilliPctPerS;
+        const int32_t absDvAfter = dvAfter < 0 ? -dvAfter : dvAfter;
+        if (crossed || (absAcc <= daMax && absDvAfter <= daMax))
+        {
+            s.velMilliPct = target;
+            s.accMilliPctPerS = 0;
+        }
+        return s;
+    }
+
+    inline bool atTarget(const MotionState &s, int8_t targetPct)
+    {
+        return s.accMilliPctPerS == 0 && s.velMilliPct == int32_t(targetPct) * MILLI_PCT_PER_PCT;
+    }
+} // namespace MotionProfile
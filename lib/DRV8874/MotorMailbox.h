@@ -0,0 +1,130 @@
+// Lock-free plumbing between the caller of DRV8874 (loop) and its control task.
+//  - SpscQueue: single-producer/single-consumer command ring (loop → control task)
+//  - SeqLock:   single-writer status snapshot without torn reads (control task → readers)
+// Both are fixed size, allocation free and safe across cores.
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+enum class MotorOp : uint8_t
+{
+    Run,
+    Coast,
+    Brake,
+    ClearStall,
+    SetPosition,
+    Calibrate,
+    Reconnect, // coast, then give IN1/IN2 back to LEDC after a fault cut-off
+};
+
+struct MotorCommand
+{
+    uint16_t seq = 0;  // producer sequence number, echoed in MotorStatus::lastCmdSeq once applied
+    MotorOp op = MotorOp::Coast;
+    int8_t speedPt = 0; // Run only; Calibrate: slowest usable speed %
+    int32_t value = 0;  // SetPosition only
+};
+
+enum class MotorState : uint8_t
+{
+    Idle,        // coasting / stopped
+    Running,     // outputs driven in currentDir
+    Braking,     // brake window active
+    Stalled,     // coasted after a stall, stallDir refused
+    Calibrating, // min-duty sweep running (see DRV8874::calibrate)
+};
+
+// Consistent view of one motor, published by its control task after every tick
+struct MotorStatus
+{
+    uint32_t dutyCmd = 0;   // applied duty (0..MAX_DUTY)
+    uint32_t currentmA = 0; // CS current when published
+    int8_t dir = 0;         // +1 forward, -1 reverse, 0 stopped
+    int8_t speedPt = 0;     // setpoint the control task works toward
+    int8_t stallDir = 0;    // direction of a latched stall, 0 = none
+    MotorState state = MotorState::Idle;
+    uint16_t lastCmdSeq = 0; // seq of the last command the control task applied
+    int32_t position = 0;    // estimated position in ripple counts (see PositionEstimator.h)
+    bool homed = false;      // position re-zeroed at an end stop (or set) since boot
+    bool rippleLive = false; // position currently counted from current ripple (else duty × time)
+    uint32_t minDutyPos = 0; // min duties in use (calibration results)
+    uint32_t minDutyNeg = 0;
+    uint8_t calSeq = 0;      // bumped by every finished calibration sweep
+    uint8_t calFound = 0;    // last sweep: bit 0 positive, bit 1 negative breakaway found
+};
+
+template <typename T, uint8_t N>
+class SpscQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    // Producer side. False if full (consumer is not keeping up).
+    bool push(const T &item)
+    {
+        const uint8_t head = _head.load(std::memory_order_relaxed);
+        if (uint8_t(head - _tail.load(std::memory_order_acquire)) >= N)
+            return false;
+        _buf[head & (N - 1)] = item;
+        _head.store(uint8_t(head + 1), std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. False if empty.
+    bool pop(T &out)
+    {
+        const uint8_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire))
+            return false;
+        out = _buf[tail & (N - 1)];
+        _tail.store(uint8_t(tail + 1), std::memory_order_release);
+        return true;
+    }
+
+private:
+    T _buf[N];
+    std::atomic<uint8_t> _head{0}; // written by producer only
+    std::atomic<uint8_t> _tail{0}; // written by consumer only
+};
+
+// Double-buffered seqlock: the writer fills the inactive buffer, then publishes it by bumping
+// the sequence. A preempted writer never blocks readers (they keep reading the published
+// buffer); a reader retries whenever the sequence changed during its copy, since the writer
+// may have started reusing the buffer it was copying.
+// The payload is copied with plain memcpy, so fences order it against the sequence: the
+// writer's release fence keeps the overwrite after the previous publish, the reader's acquire
+// fence keeps its copy before the re-check. A reader that saw any overwritten byte then also
+// sees the changed sequence.
+template <typename T>
+class SeqLock
+{
+public:
+    // Single writer
+    void store(const T &value)
+    {
+        const uint32_t next = _seq.load(std::memory_order_relaxed) + 1;
+        std::atomic_thread_fence(std::memory_order_release); // pairs with the fence in load()
+        memcpy(&_data[next & 1u], &value, sizeof(T));
+        _seq.store(next, std::memory_order_release);
+    }
+
+    // Any number of readers
+    T load() const
+    {
+        T out;
+        for (;;)
+        {
+            const uint32_t seq = _seq.load(std::memory_order_acquire);
+            memcpy(&out, &_data[seq & 1u], sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire); // pairs with the fence in store()
+            if (_seq.load(std::memory_order_relaxed) == seq)
+                return out;
+        }
+    }
+
+private:
+    std::atomic<uint32_t> _seq{0};
+    T _data[2]{};
+};
@@ -0,0 +1,106 @@
+// Sensorless position estimate in ripple counts for DRV8874 motors.
+// While ripples arrive, each edge is one count in the driven direction, and the counts per second
+// at full duty are learned. Without ripples (polling ADC, very slow speed, noise) it falls back
+// to integrating duty × time with that rate. Speed is taken as proportional to the duty above
+// the motor's min duty (the dead band where it barely turns), not to the raw duty: the fallback
+// mostly runs at crawl speeds, where the raw duty would overestimate travel many times over.
+// Re-zeroed by the driver at the end stops.
+
+#pragma once
+#include <stdint.h>
+
+#include "RippleCounter.h"
+
+struct PositionConfig
+{
+    RippleCounterConfig ripple;
+    uint32_t countsPerSAtMax = 0;  // fallback rate at MAX_DUTY; 0 = learn from ripples only
+    uint16_t rippleTimeoutMs = 50; // no edge for this long while driven → duty × time fallback
+    int32_t travelCounts = 0;      // position at the positive (lower) end stop (0 = unknown, only the upper end re-zeroes)
+};
+
+class PositionEstimator
+{
+public:
+    void configure(const PositionConfig &cfg)
+    {
+        _rateCountsPerS = cfg.countsPerSAtMax;
+        _timeoutUs = uint32_t(cfg.rippleTimeoutMs) * 1000u;
+    }
+
+    void set(int32_t pos)
+    {
+        _pos = pos;
+        _fracMilli = 0;
+    }
+
+    // Called every control tick with the state driven during the last dtUs.
+    // dir: driven direction (or the pre-brake direction while braking, with duty 0)
+    // minDuty: the direction's min duty (no motion at or below it)
+    // rippleEdges: RippleCounter::edges() now; rippleAvailable: a counter is fed
+    void update(int8_t dir, uint32_t duty, uint32_t minDuty, uint32_t maxDuty, uint32_t rippleEdges,
+                bool rippleAvailable, uint32_t dtUs)
+    {
+        const uint32_t newEdges = rippleEdges - _lastEdges;
+        _lastEdges = rippleEdges;
+        if (dir == 0)
+        {
+            _sinceEdgeUs = _timeoutUs; // next start: duty × time until the first edge
+            return;
+        }
+
+        if (rippleAvailable && newEdges > 0)
+            _sinceEdgeUs = 0;
+        else if (_sinceEdgeUs < _timeoutUs)
+            _sinceEdgeUs += dtUs;
+        _rippleLive = rippleAvailable && _sinceEdgeUs < _timeoutUs;
+
+        // Time at full speed equivalent to dtUs at this duty
+        const uint64_t fullSpeedUs = (duty > minDuty && maxDuty > minDuty)
+                                         ? (uint64_t(duty - minDuty) * dtUs) / (maxDuty - minDuty)
+                                         : 0;
+        if (_rippleLive)
+        {
+            _pos += dir * int32_t(newEdges);
+            learn(newEdges, fullSpeedUs);
+        }
+        else
+        {
+            _fracMilli += dir * int64_t((uint64_t(_rateCountsPerS) * fullSpeedUs) / 1000u);
+            _pos += int32_t(_fracMilli / 1000);
+            _fracMilli %= 1000;
+        }
+    }
+
+    int32_t position() const { return _pos; }
+    bool usingRipple() const { return _rippleLive; }
+    uint32_t rateCountsPerS() const { return _rateCountsPerS; }
+
+private:
+    static constexpr uint64_t LEARN_WINDOW_US = 100000; // 0.1 s at full speed per rate update
+
+    // Counts per second at full duty, in the same above-min-duty units as the fallback,
+    // averaged over windows with a 1/8 IIR
+    void learn(uint32_t edges, uint64_t fullSpeedUs)
+    {
+        _winEdges += edges;
+        _winFullSpeedUs += fullSpeedUs;
+        if (_winFullSpeedUs < LEARN_WINDOW_US)
+            return;
+        const uint32_t measured = uint32_t((uint64_t(_winEdges) * 1000000u) / _winFullSpeedUs);
+        _rateCountsPerS = _rateCountsPerS == 0 ? measured
+                                               : uint32_t(int32_t(_rateCountsPerS) + (int32_t(measured) - int32_t(_rateCountsPerS)) / 8);
+        _winEdges = 0;
+        _winFullSpeedUs = 0;
+    }
+
+    int32_t _pos = 0;
+    int64_t _fracMilli = 0; // sub-count remainder of the fallback
+    uint32_t _lastEdges = 0;
+    uint32_t _sinceEdgeUs = 0;
+    uint32_t _timeoutUs = 50000;
+    bool _rippleLive = false;
+    uint32_t _rateCountsPerS = 0;
+    uint32_t _winEdges = 0;
+    uint64_t _winFullSpeedUs = 0;
+};
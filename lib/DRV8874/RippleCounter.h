@@ -0,0 +1,63 @@
+// Commutation ripple counter for brushed DC motors. Every commutator segment passing a brush
+// dips the motor current, so counting the dips of the CS signal counts shaft rotation.
+// Fed per ADC conversion (AdcStream sample sink): band-pass from two fixed-point IIRs
+// (fast: noise, slow: DC / load level), then a hysteresis comparator counts rising edges.
+
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+struct RippleCounterConfig
+{
+    uint8_t fastShift = 1;      // noise low-pass: f += (x - f) >> fastShift (~800 Hz at 10 kHz/pin)
+    uint8_t slowShift = 6;      // DC tracker: s += (f - s) >> slowShift (~25 Hz at 10 kHz/pin)
+    uint16_t hysteresis = 12;   // raw ADC counts around the DC level (~10 mV, ~9 mA)
+    uint16_t minGapSamples = 4; // reject edges closer than this (faster than any real ripple)
+};
+
+class RippleCounter
+{
+public:
+    void configure(const RippleCounterConfig &cfg) { _cfg = cfg; }
+
+    // Sample hook: single writer (ADC reader task)
+    void sample(uint16_t raw)
+    {
+        const int32_t x = int32_t(raw) << 8; // Q8
+        if (!_primed)
+        {
+            _fast = _slow = x;
+            _primed = true;
+            return;
+        }
+        _fast += (x - _fast) >> _cfg.fastShift;
+        _slow += (_fast - _slow) >> _cfg.slowShift;
+        if (_gap < UINT16_MAX)
+            _gap++;
+
+        const int32_t ac = (_fast - _slow) >> 8;
+        const int32_t h = _cfg.hysteresis;
+        if (!_high && ac > h)
+        {
+            _high = true;
+            if (_gap >= _cfg.minGapSamples)
+            {
+                _edges.fetch_add(1, std::memory_order_relaxed);
+                _gap = 0;
+            }
+        }
+        else if (_high && ac < -h)
+            _high = false;
+    }
+
+    // Rising edges counted so far (wraps). Lock-free for any reader; use differences.
+    uint32_t edges() const { return _edges.load(std::memory_order_relaxed); }
+
+private:
+    RippleCounterConfig _cfg;
+    int32_t _fast = 0, _slow = 0; // Q8 raw counts
+    bool _primed = false;
+    bool _high = false;
+    uint16_t _gap = UINT16_MAX;
+    std::atomic<uint32_t> _edges{0};
+};
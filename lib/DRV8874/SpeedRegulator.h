@@ -0,0 +1,53 @@
+// Sensorless speed regulator for a brushed DC motor.
+// Speed is estimated as back-EMF in duty counts: applied duty minus the I*R drop of the
+// measured current (IR compensation). A PI term on that estimate trims the open-loop
+// (feed-forward) duty so the commanded speed holds under changing load.
+// Updated by the control task every tick while the regulator is enabled.
+
+#pragma once
+#include <stdint.h>
+
+struct SpeedRegulatorConfig
+{
+    bool enabled = false;
+    // Duty counts of I*R drop per 1 A motor current, i.e. R_winding * MAX_DUTY / V_supply.
+    // Set it somewhat below the true value: full compensation makes the loop insensitive at stall.
+    uint32_t irCompDutyPerA = 0;
+    uint32_t noLoadmA = 0;     // current at the feed-forward duty with no external load (per direction avg)
+    uint16_t kpQ8 = 0;         // proportional gain on back-EMF error, Q8 (256 = 1.0)
+    uint16_t kiQ8 = 0;         // integral gain per control tick, Q8
+    uint32_t maxTrimDuty = 0;  // clamp of the PI correction (and integrator) in duty counts
+};
+
+class SpeedRegulator
+{
+public:
+    void reset() { _integQ8 = 0; }
+
+    // One regulator step. Returns the duty to apply (0..maxDuty).
+    //  ffDuty: open-loop duty for the commanded speed (also the no-load speed reference)
+    //  appliedDuty: duty applied during the last period (the one currentmA was measured with)
+    uint32_t update(const SpeedRegulatorConfig &cfg, uint32_t ffDuty, uint32_t appliedDuty,
+                    uint32_t currentmA, uint32_t maxDuty)
+    {
+        const int32_t irRef = int32_t((uint64_t(cfg.irCompDutyPerA) * cfg.noLoadmA) / 1000u);
+        const int32_t irMeas = int32_t((uint64_t(cfg.irCompDutyPerA) * currentmA) / 1000u);
+        const int32_t emfRef = int32_t(ffDuty) - irRef;      // back-EMF expected at no load
+        const int32_t emfEst = int32_t(appliedDuty) - irMeas; // back-EMF estimated now
+        const int32_t err = emfRef - emfEst;
+
+        const int32_t trimLimQ8 = int32_t(cfg.maxTrimDuty) * 256;
+        _integQ8 = clamp(_integQ8 + int32_t(cfg.kiQ8) * err, -trimLimQ8, trimLimQ8);
+
+        const int32_t trim = clamp((int32_t(cfg.kpQ8) * err + _integQ8) / 256,
+                                   -int32_t(cfg.maxTrimDuty), int32_t(cfg.maxTrimDuty));
+        return uint32_t(clamp(int32_t(ffDuty) + trim, 0, int32_t(maxDuty)));
+    }
+
+    int32_t integratorDuty() const { return _integQ8 / 256; }
+
+private:
+    static int32_t clamp(int32_t v, int32_t lo, int32_t hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+    int32_t _integQ8 = 0;
+};
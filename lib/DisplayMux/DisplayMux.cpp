@@ -25,8 +25,9 @@ void DisplayMux::begin(uint8_t segBrightness)
   if (seg_) // ---- TM1638 Display ----
   {
     seg_->displayBegin(); // TM1638 panel init
+    invalidateShadows_();
     // Apply cached brightness on boot (255=off is honored by wrapper)
-    seg_->brightness(segBrightness);
+    writeSegBrightness_(segBrightness);
     segBrightness_ = segBrightness;
   }
 
@@ -48,16 +49,18 @@ void DisplayMux::begin(uint8_t segBrightness)
 void DisplayMux::attachTM1638(TM1638plusWrapper *seg)
 {
   seg_ = seg;
+  invalidateShadows_();
   if (begun_ && seg_)
   {
     seg_->displayBegin();
-    seg_->brightness(segBrightness_);
+    writeSegBrightness_(segBrightness_);
   }
 }
 
 void DisplayMux::attachRgbLcd(rgb_lcd *lcd)
 {
   lcd_ = lcd;
+  invalidateShadows_();
   // Force a re-probe on next use
   lcdPresent_ = false;
 }
@@ -70,15 +73,21 @@ void DisplayMux::segSetBrightness(uint8_t b)
 {
   segBrightness_ = b;
   if (seg_)
-    seg_->brightness(b);
+    writeSegBrightness_(b);
 
   broadcastIfDue(); // Broadcast change if enabled
 }
 
 void DisplayMux::segSetLEDs(uint8_t mask)
 {
-  if (seg_)
-    seg_->setLEDs(mask);
+  if (!seg_ || ledShadow_ == mask)
+    return;
+  // One command per changed LED
+  const uint8_t changed = ledShadow_ < 0 ? 0xFF : uint8_t(ledShadow_ ^ mask);
+  for (uint8_t i = 0; i < 8; ++i)
+    if (changed & (1u << i))
+      seg_->setLED(i, (mask >> i) & 1);
+  ledShadow_ = mask;
 }
 
 // Sets text for all displays, brightness for TM1638 then broadcasts it via ESP-NOW.
@@ -86,22 +95,26 @@ void DisplayMux::segSetLEDs(uint8_t mask)
 //  lcdLine1 & lcdLine2 (max 16 chars), lcdLine2 (max 16 chars) for 2x16 LCD display
 void DisplayMux::displayAndBroadCastTexts(uint8_t brightness, const char segText[11], const char lcdLine1[17], const char lcdLine2[17])
 {
+  const uint32_t now = millis();
+  if (now - lastFullRedrawMs_ >= FULL_REDRAW_MS)
+  {
+    lastFullRedrawMs_ = now;
+    invalidateShadows_();
+  }
+
   if (lcd_)
   {
     if (lcdPresent_)
     {
-      lcd_->setCursor(0, 0);
-      lcd_->print(lcdLine1);
-
-      lcd_->setCursor(0, 1);
-      lcd_->print(lcdLine2);
+      writeLcdLine_(0, lcdLine1);
+      writeLcdLine_(1, lcdLine2);
     }
   }
 
   if (seg_)
   {
-    seg_->brightness(brightness);
-    seg_->displayText(segText);
+    writeSegBrightness_(brightness);
+    writeSegText_(segText);
   }
 
   DisplayMux::segBrightness_ = brightness;
@@ -175,6 +188,64 @@ void DisplayMux::broadcastIfDue()
 }
 
 // ---- Private helpers ----
+void DisplayMux::invalidateShadows_()
+{
+  memset(lcdShadow_, 0, sizeof(lcdShadow_));
+  for (uint16_t &d : segShadow_)
+    d = SEG_UNKNOWN;
+  segBrightnessKnown_ = false;
+  ledShadow_ = -1;
+}
+
+// Writes the runs of characters that differ from the shadow: one setCursor per run
+void DisplayMux::writeLcdLine_(uint8_t row, const char *text)
+{
+  char *shadow = lcdShadow_[row];
+  int8_t cursor = -1; // column the LCD cursor is at, -1 = not placed
+  for (uint8_t col = 0; col < 16 && text[col]; ++col)
+  {
+    if (shadow[col] == text[col])
+      continue;
+    if (cursor != int8_t(col))
+      lcd_->setCursor(col, row);
+    lcd_->write(uint8_t(text[col]));
+    shadow[col] = text[col];
+    cursor = int8_t(col + 1); // auto-increment
+  }
+}
+
+// Same digit layout as TM1638plus::displayText: a '.' after a character lights that digit's dot
+void DisplayMux::writeSegText_(const char *text)
+{
+  uint8_t pos = 0;
+  while (pos < 8 && *text)
+  {
+    const char c = *text++;
+    const bool dot = (*text == '.' && c != '.');
+    if (dot)
+      text++;
+    const uint16_t cell = uint16_t(uint8_t(c)) | (dot ? 0x100 : 0);
+    if (segShadow_[pos] != cell)
+    {
+      if (dot)
+        seg_->displayASCIIwDot(pos, c);
+      else
+        seg_->displayASCII(pos, c);
+      segShadow_[pos] = cell;
+    }
+    pos++;
+  }
+}
+
+void DisplayMux::writeSegBrightness_(uint8_t b)
+{
+  if (segBrightnessKnown_ && segBrightnessShown_ == b)
+    return;
+  seg_->brightness(b);
+  segBrightnessShown_ = b;
+  segBrightnessKnown_ = true;
+}
+
 bool DisplayMux::probeLcd_()
 {
   // Suppress I2C NACK logs during probe
@@ -1,5 +1,7 @@
 // Generic display multiplexer to unify TM1638 (7-seg) and 16x2 RGB LCD usage
 // optional broadcast of displays state via ESP-NOW.
+// Shadow framebuffers per device: only changed LCD characters, TM1638 digits/LEDs and
+// brightness go out on the bus, so an unchanged display costs no I2C / bit-bang time.
 
 #pragma once
 
@@ -10,6 +12,7 @@ constexpr uint8_t DEFAULT_SEG_BRIGHTNESS = 7;
 constexpr uint8_t BROADCAST_MAC[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 constexpr uint32_t RESEND_SAME_MS = 300;        // unchanged text resend throttle
 constexpr uint32_t MIN_RESEND_INTERVAL_MS = 40; // global rate limit
+constexpr uint32_t FULL_REDRAW_MS = 5000;       // rewrite everything now and then: the devices can't be read back
 
 // Forward declarations to avoid heavy headers in this interface
 class TM1638plusWrapper;
@@ -63,6 +66,19 @@ private:
   void broadcastIfDue();
   bool probeLcd_();
 
+  // Shadow framebuffers: what the devices show now
+  void invalidateShadows_();
+  void writeLcdLine_(uint8_t row, const char *text);
+  void writeSegText_(const char *text);
+  void writeSegBrightness_(uint8_t b);
+  static constexpr uint16_t SEG_UNKNOWN = 0xFFFF;
+  char lcdShadow_[2][16] = {};   // 0 = unknown
+  uint16_t segShadow_[8] = {};   // ASCII | 0x100 with dot, SEG_UNKNOWN = unknown
+  uint8_t segBrightnessShown_ = 0;
+  bool segBrightnessKnown_ = false;
+  int16_t ledShadow_ = -1;       // -1 = unknown
+  uint32_t lastFullRedrawMs_ = 0;
+
   // Cached state for TM1638 + broadcast
   uint8_t segBrightness_ = 0xFF; // 255=OFF by wrapper semantics
   char segText_[11] = {0};
@@ -13,6 +13,7 @@
 namespace
 {
   DurstProto::DisplayBroadcastHandler s_onDisplayBroadcastHandler = nullptr;
+  DurstProto::MotorStatusHandler s_onMotorStatusHandler = nullptr;
   bool s_recvCbAttached = false;
 
   // Minimal header view for quick checks (matches start of MsgV1)
@@ -65,24 +66,49 @@ namespace
       }
       break;
 
+    case CMD_MOTOR_STATUS:
+      if (len != (int)sizeof(MsgMotorStatusV1))
+      {
+        Serial.printf("DurstProto: MOTOR_STATUS bad length. Expected: %d Actual: %d\n", sizeof(MsgMotorStatusV1), len);
+        return;
+      }
+      if (s_onMotorStatusHandler)
+      {
+        MsgMotorStatusV1 msg;
+        memcpy(&msg, data, sizeof(msg)); // packed int32 fields: don't read them in place
+        s_onMotorStatusHandler(msg);
+      }
+      break;
+
     default:
       Serial.printf("DurstProto: unknown cmd received: %u\n", (unsigned)hdr->cmd);
       break;
     }
   }
-} // namespace
 
-namespace DurstProto
-{
-  void setOnDisplayBroadcast(DisplayBroadcastHandler h)
+  void attachRecvCb()
   {
-    s_onDisplayBroadcastHandler = h;
     if (!s_recvCbAttached)
     {
       esp_now_register_recv_cb(&onEspNowRecvGeneric);
       s_recvCbAttached = true;
     }
   }
+} // namespace
+
+namespace DurstProto
+{
+  void setOnDisplayBroadcast(DisplayBroadcastHandler h)
+  {
+    s_onDisplayBroadcastHandler = h;
+    attachRecvCb();
+  }
+
+  void setOnMotorStatus(MotorStatusHandler h)
+  {
+    s_onMotorStatusHandler = h;
+    attachRecvCb();
+  }
 
   bool sendTo(const uint8_t mac[6], const void *data, size_t len)
   {
@@ -94,4 +120,9 @@ namespace DurstProto
   {
     return sendTo(BROADCAST_MAC, &msg, sizeof(msg));
   }
+
+  bool broadcastMotorStatus(const MsgMotorStatusV1 &msg)
+  {
+    return sendTo(BROADCAST_MAC, &msg, sizeof(msg));
+  }
 } // namespace DurstProto
@@ -20,9 +20,16 @@ namespace DurstProto
   // (idempotent). Keeps slave/master setup to a single call.
   void setOnDisplayBroadcast(DisplayBroadcastHandler h);
 
+  // Handler type for motor status broadcast messages
+  using MotorStatusHandler = void (*)(const MsgMotorStatusV1 &msg);
+  void setOnMotorStatus(MotorStatusHandler h);
+
   // Send current display message to broadcast MAC
   bool broadcastDisplayText(const MsgV1 &msg);
 
+  // Send motor positions to broadcast MAC
+  bool broadcastMotorStatus(const MsgMotorStatusV1 &msg);
+
   // Low-level send to a specific MAC
   bool sendTo(const uint8_t mac[6], const void *data, size_t len);
 }
@@ -25,6 +25,7 @@ constexpr void copy_literal(char (&dst)[N], const char (&lit)[M])
 enum : uint8_t
 {
     CMD_DISPLAY_TEXT = 0x01, // payload uses `text[8]`
+    CMD_MOTOR_STATUS = 0x02, // MsgMotorStatusV1: live motor positions
 };
 
 struct __attribute__((packed)) MsgV1
@@ -41,3 +42,16 @@ struct __attribute__((packed)) MsgV1
 };
 static_assert(sizeof(MsgV1) == 54, "MsgV1 must be 54 bytes");
 
+
+// Motor position broadcast (master → slaves). Positions are in ripple counts (see DRV8874)
+struct __attribute__((packed)) MsgMotorStatusV1
+{
+    uint8_t magic = PROTO_MAGIC;
+    uint8_t version = 1;
+    uint8_t cmd = CMD_MOTOR_STATUS;
+    uint8_t flags = 0;   // bit0/1: motor 1/2 homed
+    uint32_t seq = 0;    // rolling sequence number (own counter, independent of MsgV1)
+    int32_t position[2]; // motor 1, motor 2
+    int8_t dir[2];       // -1/0/+1
+};
+static_assert(sizeof(MsgMotorStatusV1) == 18, "MsgMotorStatusV1 must be 18 bytes");
@@ -0,0 +1,268 @@
+// ExposureLog: implementation
+
+#include "ExposureLog.h"
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <atomic>
+#include <time.h>
+
+#include "LampTimer.h"
+
+namespace
+{
+  constexpr BaseType_t CORE_APP = 1;
+  constexpr UBaseType_t PRIO_WRITER = tskIDLE_PRIORITY + 1; // flash I/O only when nothing else runs
+  constexpr TickType_t EXPOSING_POLL_TICKS = pdMS_TO_TICKS(100); // retry after the exposure
+  constexpr TickType_t LOCK_WAIT_TICKS = pdMS_TO_TICKS(100);     // web handlers vs a write in progress
+  constexpr time_t MIN_VALID_UNIX = 1700000000;             // before: clock not set
+  const char *const PATH_CUR = "/exposures.bin";
+  const char *const PATH_OLD = "/exposures.old";
+  const char *const PATH_TMP = "/exposures.tmp"; // repair copy of PATH_CUR
+
+  QueueHandle_t s_queue = nullptr;
+  TaskHandle_t s_task = nullptr;
+  SemaphoreHandle_t s_lock = nullptr; // files and counts: writer task vs web handlers
+  uint32_t s_curCount = 0;
+  uint32_t s_oldCount = 0;
+  std::atomic<uint32_t> s_total{0}; // s_oldCount + s_curCount, readable without s_lock
+  uint16_t s_boot = 0;
+  std::atomic<uint32_t> s_dropped{0};
+  std::atomic<bool> s_hold{false};
+
+  uint32_t recordsIn(const char *path)
+  {
+    if (!LittleFS.exists(path))
+      return 0;
+    File f = LittleFS.open(path, "r");
+    const uint32_t n = f ? uint32_t(f.size() / sizeof(ExposureLogRecord)) : 0;
+    f.close();
+    return n;
+  }
+
+  // A reset mid-write leaves a partial record at the end of the current file: copy the whole
+  // records to PATH_TMP and swap it in (LittleFS has no truncate in the Arduino File API)
+  void dropPartialRecord()
+  {
+    if (LittleFS.exists(PATH_TMP)) // reset during an earlier repair: the copy is whole once PATH_CUR is gone
+    {
+      if (LittleFS.exists(PATH_CUR))
+        LittleFS.remove(PATH_TMP);
+      else
+        LittleFS.rename(PATH_TMP, PATH_CUR);
+    }
+    File cur = LittleFS.open(PATH_CUR, "r");
+    const size_t size = cur ? cur.size() : 0;
+    const size_t keep = size - size % sizeof(ExposureLogRecord);
+    if (keep == size)
+    {
+      cur.close();
+      return;
+    }
+    File tmp = LittleFS.open(PATH_TMP, "w");
+    uint8_t buf[sizeof(ExposureLogRecord) * 8];
+    size_t copied = 0;
+    while (tmp && copied < keep)
+    {
+      const size_t n = cur.read(buf, keep - copied < sizeof(buf) ? keep - copied : sizeof(buf));
+      if (n == 0 || tmp.write(buf, n) != n)
+        break;
+      copied += n;
+    }
+    cur.close();
+    tmp.close();
+    if (copied == keep)
+    {
+      LittleFS.remove(PATH_CUR);
+      LittleFS.rename(PATH_TMP, PATH_CUR);
+      Serial.printf("ExposureLog: dropped a partial record (%u bytes)\n", unsigned(size - keep));
+    }
+    else
+    {
+      LittleFS.remove(PATH_TMP);
+      Serial.println("ExposureLog: partial record, repair failed");
+    }
+  }
+
+  // Caller holds s_lock: the current file is full, it becomes the old one
+  void rotateLocked()
+  {
+    LittleFS.remove(PATH_OLD);
+    LittleFS.rename(PATH_CUR, PATH_OLD);
+    s_oldCount = s_curCount;
+    s_curCount = 0;
+    s_total.store(s_oldCount);
+  }
+
+  void writerTaskEntry(void *)
+  {
+    ExposureLogRecord rec;
+    for (;;)
+    {
+      xQueueReceive(s_queue, &rec, portMAX_DELAY);
+      // Neither during an exposure (the cut-off alarm must not wait on flash) nor between the
+      // steps of a strip or program (the next step would wait for the write)
+      while (s_hold.load() || !LampTimer::beginFlashWrite())
+        vTaskDelay(EXPOSING_POLL_TICKS);
+      xSemaphoreTake(s_lock, portMAX_DELAY);
+      File f;
+      do // drain the queue into one open/close
+      {
+        if (s_curCount >= ExposureLog::RECORDS_PER_FILE)
+        {
+          f.close();
+          rotateLocked();
+        }
+        if (!f)
+          f = LittleFS.open(PATH_CUR, "a");
+        if (!f || f.write(reinterpret_cast<const uint8_t *>(&rec), sizeof(rec)) != sizeof(rec))
+        {
+          Serial.println("ExposureLog: write failed");
+          break;
+        }
+        s_curCount++;
+        s_total.store(s_oldCount + s_curCount);
+      } while (xQueueReceive(s_queue, &rec, 0) == pdTRUE);
+      f.close();
+      xSemaphoreGive(s_lock);
+      LampTimer::endFlashWrite();
+    }
+  }
+
+  // Caller holds s_lock. Record i, 0 = oldest.
+  bool readLocked(uint32_t i, ExposureLogRecord &rec, File &oldFile, File &curFile)
+  {
+    File &f = i < s_oldCount ? oldFile : curFile;
+    const uint32_t at = i < s_oldCount ? i : i - s_oldCount;
+    if (!f)
+      f = LittleFS.open(i < s_oldCount ? PATH_OLD : PATH_CUR, "r");
+    return f && f.seek(at * sizeof(ExposureLogRecord)) &&
+           f.read(reinterpret_cast<uint8_t *>(&rec), sizeof(rec)) == sizeof(rec);
+  }
+} // namespace
+
+namespace ExposureLog
+{
+  void begin()
+  {
+    if (s_task)
+      return;
+    if (!(LittleFS.begin(false) || LittleFS.begin(true))) // idempotent
+    {
+      Serial.println("ExposureLog: LittleFS mount failed");
+      return;
+    }
+
+    Preferences prefs;
+    if (prefs.begin("explog", false))
+    {
+      s_boot = uint16_t(prefs.getUShort("boot", 0) + 1);
+      prefs.putUShort("boot", s_boot);
+      prefs.end();
+    }
+
+    dropPartialRecord();
+    s_curCount = recordsIn(PATH_CUR);
+    s_oldCount = recordsIn(PATH_OLD);
+    s_total.store(s_oldCount + s_curCount);
+
+    s_lock = xSemaphoreCreateMutex();
+    s_queue = xQueueCreate(QUEUE_DEPTH, sizeof(ExposureLogRecord));
+    if (!s_lock || !s_queue)
+    {
+      Serial.println("ExposureLog: allocation failed");
+      return;
+    }
+    xTaskCreatePinnedToCore(writerTaskEntry, "exposure_log", 4096, nullptr, PRIO_WRITER, &s_task, CORE_APP);
+    Serial.printf("ExposureLog: boot %u, %lu records\n", s_boot, (unsigned long)(s_oldCount + s_curCount));
+  }
+
+  bool append(ExposureLogRecord rec)
+  {
+    if (!s_queue)
+      return false;
+    const time_t now = time(nullptr);
+    rec.unixTime = now >= MIN_VALID_UNIX ? uint32_t(now) : 0;
+    rec.boot = s_boot;
+    if (xQueueSend(s_queue, &rec, 0) != pdTRUE)
+    {
+      s_dropped.fetch_add(1);
+      return false;
+    }
+    return true;
+  }
+
+  void holdWrites(bool hold) { s_hold.store(hold); }
+
+  uint32_t count() { return s_total.load(); }
+
+  uint32_t dropped() { return s_dropped.load(); }
+
+  void attachRoutes(AsyncWebServer &server)
+  {
+    server.on("/log/api/status", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      AsyncResponseStream *res = req->beginResponseStream("application/json");
+      res->printf("{\"count\":%lu,\"dropped\":%lu,\"boot\":%u,\"perFile\":%u,\"clockSet\":%s}", (unsigned long)count(),
+                  (unsigned long)dropped(), s_boot, (unsigned)RECORDS_PER_FILE,
+                  time(nullptr) >= MIN_VALID_UNIX ? "true" : "false");
+      req->send(res); });
+
+    // One page at a time: at most PAGE_MAX records are read, newest first
+    server.on("/log/api/exposures", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      if (!s_lock) { req->send(503, "text/plain", "log not running"); return; }
+      const uint32_t offset = req->hasParam("offset") ? uint32_t(req->getParam("offset")->value().toInt()) : 0;
+      uint32_t limit = req->hasParam("limit") ? uint32_t(req->getParam("limit")->value().toInt()) : 20;
+      if (limit == 0 || limit > PAGE_MAX)
+        limit = PAGE_MAX;
+
+      if (xSemaphoreTake(s_lock, LOCK_WAIT_TICKS) != pdTRUE) { req->send(503, "text/plain", "log busy, retry"); return; }
+      AsyncResponseStream *res = req->beginResponseStream("application/json");
+      const uint32_t total = s_oldCount + s_curCount;
+      res->printf("{\"total\":%lu,\"offset\":%lu,\"records\":[", (unsigned long)total, (unsigned long)offset);
+      File oldFile, curFile;
+      ExposureLogRecord r;
+      for (uint32_t k = 0; k < limit && offset + k < total; ++k)
+      {
+        if (!readLocked(total - 1 - offset - k, r, oldFile, curFile))
+          break;
+        res->printf("%s{\"unix\":%lu,\"boot\":%u,\"uptimeMs\":%lu,\"mode\":%u,\"step\":%u,\"requestedMs\":%lu,"
+                    "\"lampMs\":%lu,\"head\":%ld,\"lens\":%ld,\"fStopOffset\":%d,\"flags\":%u}",
+                    k ? "," : "", (unsigned long)r.unixTime, r.boot, (unsigned long)r.uptimeMs, r.mode, r.step,
+                    (unsigned long)r.requestedMs, (unsigned long)r.lampMs, (long)r.headPos, (long)r.lensPos,
+                    r.fStopOffset, r.flags);
+      }
+      oldFile.close();
+      curFile.close();
+      xSemaphoreGive(s_lock);
+      res->print("]}");
+      req->send(res); });
+
+    // Raw download, streamed from flash by the web server
+    server.on("/log/api/exposures.bin", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      if (!LittleFS.exists(PATH_CUR)) { req->send(404, "text/plain", "empty log"); return; }
+      req->send(LittleFS, PATH_CUR, "application/octet-stream"); });
+
+    server.on("/log/api/clear", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      if (!s_lock) { req->send(503, "text/plain", "log not running"); return; }
+      if (!LampTimer::beginFlashWrite()) { req->send(409, "text/plain", "exposure running"); return; }
+      if (xSemaphoreTake(s_lock, LOCK_WAIT_TICKS) != pdTRUE)
+      {
+        LampTimer::endFlashWrite();
+        req->send(503, "text/plain", "log busy, retry");
+        return;
+      }
+      LittleFS.remove(PATH_CUR);
+      LittleFS.remove(PATH_OLD);
+      s_curCount = s_oldCount = 0;
+      s_total.store(0);
+      xSemaphoreGive(s_lock);
+      LampTimer::endFlashWrite();
+      req->send(200, "application/json", "{\"ok\":true}"); });
+  }
+} // namespace ExposureLog
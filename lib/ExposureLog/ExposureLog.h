@@ -0,0 +1,65 @@
+// ExposureLog: persistent record of every exposure, so a good print can be repeated later.
+// Append-only file of fixed 32-byte records on LittleFS (/exposures.bin; when it is full it
+// becomes /exposures.old and a new file starts, so the log keeps the last 2–4 K exposures).
+// append() only copies the record into a queue; a low-priority writer task does the flash I/O,
+// so the exposure path never waits on LittleFS; it also holds its writes until the lamp is off
+// (LampTimer::beginFlashWrite) and a strip or program is over (holdWrites). Web pages read
+// records straight from the files. The wall clock comes from SNTP, configured by the app.
+
+#pragma once
+
+#include <stdint.h>
+
+class AsyncWebServer;
+
+struct __attribute__((packed)) ExposureLogRecord
+{
+  uint32_t unixTime = 0;    // wall clock (NTP over STA), 0 if not set
+  uint32_t uptimeMs = 0;    // millis() at the end of the exposure
+  uint16_t boot = 0;        // boot counter: orders records without a wall clock
+  uint8_t mode = 0;         // mainMaster ExposureMode: 0 single, 1 test strip, 2 program, 3 light meter
+  uint8_t step = 0;         // test strip step / program segment (0-based)
+  uint32_t requestedMs = 0; // exposure asked for (timer time, strip step, program lamp span)
+  uint32_t lampMs = 0;      // measured lamp on-time
+  int32_t headPos = 0;      // motor 1 position (ripple counts)
+  int32_t lensPos = 0;      // motor 2 position
+  int16_t fStopOffset = 0;  // twelfths of a stop (f-stop mode)
+  uint8_t flags = 0;        // ExposureLog::FLAG_* bits
+  uint8_t reserved = 0;
+};
+static_assert(sizeof(ExposureLogRecord) == 32, "ExposureLogRecord must be 32 bytes");
+
+namespace ExposureLog
+{
+  constexpr uint16_t RECORDS_PER_FILE = 2048; // 64 KB per file, two files
+  constexpr uint8_t QUEUE_DEPTH = 16;
+  constexpr uint8_t PAGE_MAX = 64; // records per JSON page
+
+  enum Flag : uint8_t
+  {
+    FLAG_CANCELLED = 0x01,
+    FLAG_FSTOP = 0x02,      // f-stop timer mode
+    FLAG_HEAD_HOMED = 0x04, // positions valid
+    FLAG_LENS_HOMED = 0x08,
+    FLAG_METERED = 0x10,    // ended by the light meter
+  };
+
+  // Mount LittleFS (idempotent), drop a partial record left by a reset, count the records and
+  // start the writer task.
+  void begin();
+
+  // Queue a record (boot and unixTime are filled in). Never blocks: false if the queue is full,
+  // the record is dropped and counted.
+  bool append(ExposureLogRecord rec);
+
+  // Keep queued records in RAM while a sequence of exposures runs (test strip, program), so no
+  // step waits for a write. Call from loop.
+  void holdWrites(bool hold);
+
+  uint32_t count(); // records in both files (written ones; queued not included)
+  uint32_t dropped();
+
+  // GET /log/api/status, GET /log/api/exposures?offset=&limit= (JSON page, newest first),
+  // GET /log/api/exposures.bin (current file, raw records), POST /log/api/clear
+  void attachRoutes(AsyncWebServer &server);
+} // namespace ExposureLog
@@ -0,0 +1,299 @@
+// ExposureProgram: implementation
+
+#include "ExposureProgram.h"
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <Preferences.h>
+#include <esp_timer.h>
+#include <stdlib.h>
+
+#include "LampTimer.h"
+
+namespace
+{
+  using ExposureProgram::Program;
+  using ExposureProgram::Segment;
+  using ExposureProgram::State;
+
+  Preferences s_prefs;
+  esp_timer_handle_t s_timer = nullptr;
+
+  // Shared between loop (start/cancel/set) and the esp_timer task (segment boundaries)
+  portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+  Program s_prog;
+  State s_state = State::Idle;
+  uint8_t s_seg = 0;
+  int64_t s_segEndUs = 0; // absolute deadline of the current segment
+  uint32_t s_groupMs = 0;
+  uint8_t s_cues = 0;
+  bool s_finished = false;
+  uint32_t s_lampMs = 0; // lamp span entered by a boundary, started from loop by service()
+
+  bool isLamp(uint8_t i) { return s_prog.seg[i].flags & ExposureProgram::SEG_LAMP; }
+
+  // Lamp-on time from segment i to the next lamp-off segment, wait or the end
+  uint32_t spanMs(uint8_t i)
+  {
+    uint32_t ms = 0;
+    for (uint8_t k = i; k < s_prog.count && isLamp(k) && (k == i || !(s_prog.seg[k].flags & ExposureProgram::SEG_WAIT)); ++k)
+      ms += s_prog.seg[k].durationMs;
+    return ms;
+  }
+
+  uint32_t groupLengthMs(uint8_t first)
+  {
+    uint32_t ms = 0;
+    for (uint8_t k = first; k < s_prog.count && (k == first || !(s_prog.seg[k].flags & ExposureProgram::SEG_WAIT)); ++k)
+      ms += s_prog.seg[k].durationMs;
+    return ms;
+  }
+
+  // Enter segment s_seg of a running group: cue, lamp span, deadline. Caller holds s_mux and
+  // arms the boundary timer for the returned deadline after unlocking.
+  int64_t enterSegmentLocked(bool groupStart)
+  {
+    const Segment &sg = s_prog.seg[s_seg];
+    if (sg.flags & ExposureProgram::SEG_CUE)
+      s_cues++;
+    s_segEndUs += int64_t(sg.durationMs) * 1000;
+    if (isLamp(s_seg) && (groupStart || !isLamp(s_seg - 1)))
+      s_lampMs = spanMs(s_seg);
+    return s_segEndUs;
+  }
+
+  void armBoundary(int64_t deadlineUs)
+  {
+    const int64_t waitUs = deadlineUs - esp_timer_get_time();
+    esp_timer_stop(s_timer); // a boundary of a cancelled group may still be pending
+    esp_timer_start_once(s_timer, waitUs > 0 ? uint64_t(waitUs) : 1);
+  }
+
+  // esp_timer task: segment over, chain the next one from the same absolute time base
+  void onBoundary(void *)
+  {
+    int64_t deadlineUs = 0;
+    portENTER_CRITICAL(&s_mux);
+    if (s_state == State::Running)
+    {
+      if (esp_timer_get_time() < s_segEndUs)
+        deadlineUs = s_segEndUs; // a stale arm from a cancelled group: wait for the real deadline
+      else if (++s_seg >= s_prog.count)
+      {
+        s_state = State::Idle;
+        s_finished = true;
+      }
+      else if (s_prog.seg[s_seg].flags & ExposureProgram::SEG_WAIT)
+        s_state = State::Waiting;
+      else
+        deadlineUs = enterSegmentLocked(false);
+    }
+    portEXIT_CRITICAL(&s_mux);
+    if (deadlineUs)
+      armBoundary(deadlineUs);
+  }
+
+  bool valid(const Program &prog)
+  {
+    if (prog.count == 0 || prog.count > ExposureProgram::MAX_SEGMENTS)
+      return false;
+    uint32_t groupMs = 0;
+    for (uint8_t i = 0; i < prog.count; ++i)
+    {
+      if (prog.seg[i].durationMs == 0 || prog.seg[i].durationMs > ExposureProgram::MAX_SEGMENT_MS)
+        return false;
+      if (prog.seg[i].flags & ExposureProgram::SEG_WAIT)
+        groupMs = 0;
+      groupMs += prog.seg[i].durationMs; // at most 16 × MAX_SEGMENT_MS: no overflow
+      if (groupMs > ExposureProgram::MAX_GROUP_MS)
+        return false;
+    }
+    return true;
+  }
+
+  void defaultProgram(Program &prog)
+  {
+    using namespace ExposureProgram;
+    prog = Program{};
+    prog.seg[0] = {4000, SEG_LAMP};                  // base
+    prog.seg[1] = {3000, SEG_LAMP | SEG_CUE};        // dodge window
+    prog.seg[2] = {3000, SEG_LAMP | SEG_CUE};        // rest of the base
+    prog.seg[3] = {5000, SEG_LAMP | SEG_WAIT};       // burn
+    prog.count = 4;
+  }
+} // namespace
+
+namespace ExposureProgram
+{
+  void begin()
+  {
+    s_prefs.begin("program", false);
+    Program prog;
+    const size_t len = s_prefs.getBytesLength("segs");
+    if (len >= 1 && len <= sizeof(Segment) * MAX_SEGMENTS + 1 && (len - 1) % sizeof(Segment) == 0)
+    {
+      uint8_t buf[sizeof(Segment) * MAX_SEGMENTS + 1];
+      s_prefs.getBytes("segs", buf, len);
+      prog.count = buf[0];
+      memcpy(prog.seg, buf + 1, len - 1);
+    }
+    if (!valid(prog) || prog.count != (len - 1) / sizeof(Segment))
+      defaultProgram(prog);
+    s_prog = prog;
+
+    esp_timer_create_args_t args = {};
+    args.callback = onBoundary;
+    args.name = "ExposureProgram";
+    if (esp_timer_create(&args, &s_timer) != ESP_OK)
+      Serial.println("ExposureProgram: esp_timer_create failed");
+    Serial.printf("ExposureProgram: %u segments\n", s_prog.count);
+  }
+
+  Program program()
+  {
+    portENTER_CRITICAL(&s_mux);
+    const Program prog = s_prog;
+    portEXIT_CRITICAL(&s_mux);
+    return prog;
+  }
+
+  bool set(const Program &prog)
+  {
+    if (!valid(prog) || !LampTimer::beginFlashWrite())
+      return false;
+    portENTER_CRITICAL(&s_mux);
+    const bool idle = s_state == State::Idle;
+    if (idle)
+      s_prog = prog;
+    portEXIT_CRITICAL(&s_mux);
+    if (!idle)
+    {
+      LampTimer::endFlashWrite();
+      return false;
+    }
+
+    uint8_t buf[sizeof(Segment) * MAX_SEGMENTS + 1];
+    buf[0] = prog.count;
+    memcpy(buf + 1, prog.seg, sizeof(Segment) * prog.count);
+    s_prefs.putBytes("segs", buf, 1 + sizeof(Segment) * prog.count);
+    LampTimer::endFlashWrite();
+    Serial.printf("ExposureProgram: saved %u segments\n", prog.count);
+    return true;
+  }
+
+  bool start()
+  {
+    if (!s_timer)
+      return false;
+    portENTER_CRITICAL(&s_mux);
+    if (s_state == State::Running)
+    {
+      portEXIT_CRITICAL(&s_mux);
+      return false;
+    }
+    if (s_state == State::Idle)
+      s_seg = 0;
+    s_state = State::Running;
+    s_groupMs = groupLengthMs(s_seg);
+    s_segEndUs = esp_timer_get_time(); // group time base
+    const int64_t deadlineUs = enterSegmentLocked(true);
+    portEXIT_CRITICAL(&s_mux);
+    armBoundary(deadlineUs);
+    service();
+    return true;
+  }
+
+  void service()
+  {
+    portENTER_CRITICAL(&s_mux);
+    const uint32_t lampMs = s_state == State::Running ? s_lampMs : 0;
+    s_lampMs = 0;
+    portEXIT_CRITICAL(&s_mux);
+    if (lampMs)
+      LampTimer::start(lampMs);
+  }
+
+  void cancel()
+  {
+    portENTER_CRITICAL(&s_mux);
+    s_state = State::Idle;
+    s_lampMs = 0;
+    portEXIT_CRITICAL(&s_mux);
+    if (s_timer)
+      esp_timer_stop(s_timer);
+    LampTimer::cancel(); // lamp spans start in loop (service()), so none can start after this
+  }
+
+  State state() { return s_state; }
+
+  uint8_t segmentIndex() { return s_seg; }
+
+  uint32_t groupMs() { return s_groupMs; }
+
+  bool takeCue()
+  {
+    portENTER_CRITICAL(&s_mux);
+    const bool cue = s_cues > 0;
+    if (cue)
+      s_cues--;
+    portEXIT_CRITICAL(&s_mux);
+    return cue;
+  }
+
+  bool takeFinished()
+  {
+    portENTER_CRITICAL(&s_mux);
+    const bool finished = s_finished;
+    s_finished = false;
+    portEXIT_CRITICAL(&s_mux);
+    return finished;
+  }
+
+  bool parse(const char *text, Program &out)
+  {
+    out = Program{};
+    const char *p = text;
+    while (*p)
+    {
+      if (out.count >= MAX_SEGMENTS)
+        return false;
+      char *end;
+      const unsigned long ms = strtoul(p, &end, 10);
+      if (end == p || *end != ',')
+        return false;
+      p = end + 1;
+      const unsigned long flags = strtoul(p, &end, 10);
+      if (end == p || (*end != ';' && *end != '\0') || flags > (SEG_LAMP | SEG_CUE | SEG_WAIT))
+        return false;
+      out.seg[out.count].durationMs = uint32_t(ms);
+      out.seg[out.count].flags = uint8_t(flags);
+      out.count++;
+      p = *end ? end + 1 : end;
+    }
+    return valid(out);
+  }
+
+  void attachRoutes(AsyncWebServer &server)
+  {
+    server.on("/program/api/program", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      const Program prog = program();
+      AsyncResponseStream *res = req->beginResponseStream("application/json");
+      res->printf("{\"state\":%u,\"segment\":%u,\"maxSegments\":%u,\"segments\":[", (unsigned)state(),
+                  (unsigned)segmentIndex(), (unsigned)MAX_SEGMENTS);
+      for (uint8_t i = 0; i < prog.count; ++i)
+        res->printf("%s{\"ms\":%lu,\"lamp\":%s,\"cue\":%s,\"wait\":%s}", i ? "," : "",
+                    (unsigned long)prog.seg[i].durationMs, (prog.seg[i].flags & SEG_LAMP) ? "true" : "false",
+                    (prog.seg[i].flags & SEG_CUE) ? "true" : "false", (prog.seg[i].flags & SEG_WAIT) ? "true" : "false");
+      res->print("]}");
+      req->send(res); });
+
+    server.on("/program/api/program", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      if (!req->hasParam("segs", true)) { req->send(400, "text/plain", "segs=ms,flags;..."); return; }
+      Program prog;
+      if (!parse(req->getParam("segs", true)->value().c_str(), prog)) { req->send(400, "text/plain", "invalid program"); return; }
+      if (!set(prog)) { req->send(409, "text/plain", "program or exposure running"); return; }
+      req->send(200, "application/json", "{\"ok\":true}"); });
+  }
+} // namespace ExposureProgram
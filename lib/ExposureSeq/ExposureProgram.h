@@ -0,0 +1,75 @@
+// ExposureProgram: multi-segment exposures for dodging and burning. A program is a list of
+// segments, each with a duration, lamp on/off, a cue beep at its start (e.g. dodge windows inside
+// the base exposure) and an optional wait for Start timer before it (e.g. place the burn card).
+// Segments between waits form a group that runs unattended: every boundary is an absolute
+// deadline from the group start (one-shot esp_timer re-armed per segment, no cumulative drift),
+// and each contiguous lamp-on span is one LampTimer exposure, cut from the timer ISR. The timer
+// callback only marks a span due; service() in loop switches the lamp on (a loop pass later, the
+// span length is unaffected).
+// One program, stored in NVS and edited from the web UI (/program/index.html).
+
+#pragma once
+
+#include <stdint.h>
+
+class AsyncWebServer;
+
+namespace ExposureProgram
+{
+  constexpr uint8_t MAX_SEGMENTS = 16;
+  constexpr uint32_t MAX_SEGMENT_MS = 999900;
+  constexpr uint32_t MAX_GROUP_MS = 9999000; // segments between waits: timer and display range
+
+  enum SegmentFlag : uint8_t
+  {
+    SEG_LAMP = 0x01, // lamp on during the segment
+    SEG_CUE = 0x02,  // beep when the segment starts
+    SEG_WAIT = 0x04, // wait for Start timer before the segment
+  };
+
+  struct __attribute__((packed)) Segment
+  {
+    uint32_t durationMs = 0;
+    uint8_t flags = 0;
+  };
+
+  struct Program
+  {
+    uint8_t count = 0;
+    Segment seg[MAX_SEGMENTS];
+  };
+
+  enum class State : uint8_t
+  {
+    Idle,
+    Running, // a group is timing
+    Waiting, // for Start timer before the next group
+  };
+
+  // Load from NVS (default: 10 s base with a 3 s dodge window, then a 5 s burn) and create the timer
+  void begin();
+
+  Program program();
+  // Replace and persist the program. Refused (false) while a program or exposure runs, or if invalid.
+  bool set(const Program &prog);
+
+  // Start timer: Idle → run the first group; Waiting → run the next group. Call from loop.
+  bool start();
+  void cancel();
+  // Starts a lamp span a segment boundary has entered. Call every loop.
+  void service();
+
+  State state();
+  uint8_t segmentIndex(); // segment running or waited for
+  uint32_t groupMs();     // length of the group started last (UI countdown)
+
+  // Events for loop(): true once per cue / per finished program
+  bool takeCue();
+  bool takeFinished();
+
+  // Text form "ms,flags;ms,flags;..." used by the web API. False if malformed.
+  bool parse(const char *text, Program &out);
+
+  // GET /program/api/program (JSON), POST /program/api/program (form field segs=<text form>)
+  void attachRoutes(AsyncWebServer &server);
+} // namespace ExposureProgram
@@ -0,0 +1,45 @@
+// Test strip timeline: N incremental exposures where strip i ends up with the cumulative time
+// t(i) = base + i·increment (linear) or base · 2^(i·twelfths / 12) (f-stop spacing). The card is
+// moved between steps, so step i only adds t(i) − t(i−1). Steps are differences of the rounded
+// cumulative times: the strips get exactly t(i), without rounding drift along the sequence.
+
+#pragma once
+#include <stdint.h>
+
+#include "FStop.h"
+
+struct TestStripConfig
+{
+    uint8_t steps = 6;
+    bool fStop = false;            // spacing: f-stop (incrementTwelfths) or linear (incrementMs)
+    uint32_t baseMs = 5000;        // first strip
+    uint32_t incrementMs = 5000;   // linear: added per strip
+    int16_t incrementTwelfths = 4; // f-stop: 1/3 stop per strip
+};
+
+namespace TestStrip
+{
+    constexpr uint8_t MAX_STEPS = 12;
+
+    // Cumulative time of strip i
+    inline uint32_t cumulativeMs(const TestStripConfig &cfg, uint8_t i)
+    {
+        return cfg.fStop ? FStop::scaleMs(cfg.baseMs, int16_t(i * cfg.incrementTwelfths)) : cfg.baseMs + i * cfg.incrementMs;
+    }
+
+    // Fills the per-step lamp times; returns the number of steps (0: nothing to expose)
+    inline uint8_t build(const TestStripConfig &cfg, uint32_t (&stepMs)[MAX_STEPS])
+    {
+        const uint8_t n = cfg.steps > MAX_STEPS ? MAX_STEPS : cfg.steps;
+        uint32_t prev = 0;
+        for (uint8_t i = 0; i < n; ++i)
+        {
+            const uint32_t t = cumulativeMs(cfg, i);
+            if (t <= prev) // increment rounds to nothing: the strips would not differ
+                return 0;
+            stepMs[i] = t - prev;
+            prev = t;
+        }
+        return n;
+    }
+} // namespace TestStrip
@@ -0,0 +1,264 @@
+// FaultManager: implementation
+
+#include "FaultManager.h"
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_timer.h>
+#include <atomic>
+
+#include "DRV8874.h"
+
+namespace
+{
+  struct FaultPin
+  {
+    uint8_t pin = 0;
+    uint8_t mask = 0; // motors on this line
+  };
+
+  DRV8874 *s_motors[FaultManager::MAX_MOTORS] = {};
+  uint8_t s_motorPin[FaultManager::MAX_MOTORS] = {};
+  uint8_t s_motorCount = 0;
+  FaultPin s_pins[FaultManager::MAX_MOTORS];
+  uint8_t s_pinCount = 0;
+
+  // Written by the ISR and the confirm timer, under s_mux everywhere else
+  portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+  volatile uint8_t s_pending = 0;    // cut by the ISR, waiting for the re-sample
+  volatile uint8_t s_latched = 0;
+  volatile uint8_t s_unserviced = 0; // latched, not yet seen by service()
+  volatile uint8_t s_glitched = 0;   // cut by a glitch, outputs to reconnect in service()
+  uint32_t s_isrUs[FaultManager::MAX_MOTORS] = {};
+  uint32_t s_cutCycles[FaultManager::MAX_MOTORS] = {};
+  FaultManager::Stats s_stats[FaultManager::MAX_MOTORS];
+  esp_timer_handle_t s_confirmTimer = nullptr;
+
+  std::atomic<bool> s_recoverRequest{false};
+
+  void IRAM_ATTR onFault(void *arg)
+  {
+    const uint32_t t0 = ESP.getCycleCount();
+    const FaultPin *fp = static_cast<const FaultPin *>(arg);
+    for (uint8_t i = 0; i < s_motorCount; ++i)
+      if (fp->mask & (1u << i))
+        s_motors[i]->cutOutputsFromIsr();
+    const uint32_t cutCycles = ESP.getCycleCount() - t0;
+    const uint32_t nowUs = uint32_t(esp_timer_get_time());
+
+    portENTER_CRITICAL_ISR(&s_mux);
+    // The driver retries: repeated edges of a latched or pending fault count once
+    const uint8_t fresh = fp->mask & ~(s_latched | s_pending);
+    for (uint8_t i = 0; i < s_motorCount; ++i)
+    {
+      if (!(fresh & (1u << i)))
+        continue;
+      s_cutCycles[i] = cutCycles;
+      s_isrUs[i] = nowUs;
+    }
+    s_pending |= fresh;
+    portEXIT_CRITICAL_ISR(&s_mux);
+    if (fresh)
+      esp_timer_start_once(s_confirmTimer, FaultManager::CONFIRM_US); // already running: it re-arms itself
+  }
+
+  // esp_timer task, CONFIRM_US after an edge: latch the motors whose pin is still low
+  void onConfirm(void *)
+  {
+    const uint32_t nowUs = uint32_t(esp_timer_get_time());
+    uint32_t rearmUs = 0;
+    portENTER_CRITICAL(&s_mux);
+    const uint8_t pending = s_pending;
+    portEXIT_CRITICAL(&s_mux);
+    for (uint8_t i = 0; i < s_motorCount; ++i)
+    {
+      if (!(pending & (1u << i)))
+        continue;
+      const uint32_t ageUs = nowUs - s_isrUs[i];
+      if (ageUs < FaultManager::CONFIRM_US) // edge on another line during this window
+      {
+        const uint32_t left = FaultManager::CONFIRM_US - ageUs;
+        rearmUs = rearmUs == 0 || left < rearmUs ? left : rearmUs;
+        continue;
+      }
+      const bool low = digitalRead(s_motorPin[i]) == LOW;
+      portENTER_CRITICAL(&s_mux);
+      FaultManager::Stats &st = s_stats[i];
+      if (low)
+      {
+        st.count++;
+        st.lastCutCycles = s_cutCycles[i];
+        if (s_cutCycles[i] > st.maxCutCycles)
+          st.maxCutCycles = s_cutCycles[i];
+        s_latched |= (1u << i);
+        s_unserviced |= (1u << i);
+      }
+      else
+      {
+        st.glitches++;
+        s_glitched |= (1u << i);
+      }
+      s_pending &= ~(1u << i);
+      portEXIT_CRITICAL(&s_mux);
+    }
+    if (rearmUs)
+      esp_timer_start_once(s_confirmTimer, rearmUs);
+  }
+
+  uint32_t cyclesToNs(uint32_t cycles)
+  {
+    return uint32_t((uint64_t(cycles) * 1000u) / getCpuFrequencyMhz());
+  }
+} // namespace
+
+namespace FaultManager
+{
+  void attach(uint8_t faultPin, DRV8874 *motor)
+  {
+    if (s_motorCount >= MAX_MOTORS)
+      return;
+    const uint8_t idx = s_motorCount;
+    s_motors[idx] = motor;
+    s_motorPin[idx] = faultPin;
+
+    FaultPin *fp = nullptr;
+    for (uint8_t i = 0; i < s_pinCount; ++i)
+      if (s_pins[i].pin == faultPin)
+        fp = &s_pins[i];
+
+    portENTER_CRITICAL(&s_mux);
+    s_motorCount++;
+    if (fp)
+      fp->mask |= (1u << idx); // shared line: the registered ISR picks the motor up
+    portEXIT_CRITICAL(&s_mux);
+    if (fp)
+      return;
+
+    if (!s_confirmTimer)
+    {
+      esp_timer_create_args_t args = {};
+      args.callback = &onConfirm;
+      args.name = "faultConfirm";
+      esp_timer_create(&args, &s_confirmTimer);
+    }
+
+    fp = &s_pins[s_pinCount++];
+    fp->pin = faultPin;
+    fp->mask = (1u << idx);
+    pinMode(faultPin, INPUT_PULLUP); // or INPUT with external 10k
+    attachInterruptArg(digitalPinToInterrupt(faultPin), onFault, fp, FALLING);
+    if (digitalRead(faultPin) == LOW) // already asserted: the edge happened before the ISR existed
+      onFault(fp);
+  }
+
+  uint8_t service()
+  {
+    uint8_t fresh, glitched;
+    uint32_t isrUs[MAX_MOTORS];
+    portENTER_CRITICAL(&s_mux);
+    fresh = s_unserviced;
+    s_unserviced = 0;
+    glitched = s_glitched;
+    s_glitched = 0;
+    memcpy(isrUs, s_isrUs, sizeof(isrUs));
+    portEXIT_CRITICAL(&s_mux);
+
+    for (uint8_t i = 0; i < s_motorCount; ++i)
+      if ((glitched & (1u << i)) && !(s_latched & (1u << i)) && s_motors[i]->isOutputCut())
+      {
+        s_motors[i]->reconnectOutputs();
+        Serial.printf("FaultManager: M%u nFAULT glitch shorter than %lu us, outputs reconnected\n", i + 1,
+                      (unsigned long)CONFIRM_US);
+      }
+
+    const uint32_t nowUs = uint32_t(esp_timer_get_time());
+    for (uint8_t i = 0; i < s_motorCount; ++i)
+    {
+      if (!(fresh & (1u << i)))
+        continue;
+      const uint32_t noticeUs = nowUs - isrUs[i];
+      portENTER_CRITICAL(&s_mux);
+      Stats &st = s_stats[i];
+      st.lastNoticeUs = noticeUs;
+      if (noticeUs > st.maxNoticeUs)
+        st.maxNoticeUs = noticeUs;
+      const uint32_t cutCycles = st.lastCutCycles;
+      portEXIT_CRITICAL(&s_mux);
+      s_motors[i]->coast(); // pins are already low; reset the control state behind them
+      Serial.printf("FaultManager: M%u fault, outputs cut in %lu ns, loop noticed after %lu us\n", i + 1,
+                    (unsigned long)cyclesToNs(cutCycles), (unsigned long)noticeUs);
+    }
+
+    if (s_recoverRequest.exchange(false))
+      recover();
+    return fresh;
+  }
+
+  bool isLatched(uint8_t motorIdx) { return s_latched & (1u << motorIdx); }
+
+  uint8_t latchedMask() { return s_latched; }
+
+  bool isPinLow(uint8_t motorIdx)
+  {
+    return motorIdx < s_motorCount && digitalRead(s_motorPin[motorIdx]) == LOW;
+  }
+
+  Stats stats(uint8_t motorIdx)
+  {
+    Stats st;
+    if (motorIdx >= s_motorCount)
+      return st;
+    portENTER_CRITICAL(&s_mux);
+    st = s_stats[motorIdx];
+    portEXIT_CRITICAL(&s_mux);
+    return st;
+  }
+
+  bool recover()
+  {
+    for (uint8_t i = 0; i < s_motorCount; ++i)
+      if (isPinLow(i))
+      {
+        Serial.printf("FaultManager: M%u nFAULT still low, not recovering\n", i + 1);
+        return false;
+      }
+
+    portENTER_CRITICAL(&s_mux);
+    s_latched = 0;
+    s_unserviced = 0;
+    portEXIT_CRITICAL(&s_mux);
+    for (uint8_t i = 0; i < s_motorCount; ++i)
+      if (s_motors[i]->isOutputCut())
+        s_motors[i]->reconnectOutputs();
+    Serial.println("FaultManager: recovered");
+    return true;
+  }
+
+  void requestRecover() { s_recoverRequest.store(true); }
+
+  void attachRoutes(AsyncWebServer &server)
+  {
+    server.on("/fault/api/status", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      AsyncResponseStream *res = req->beginResponseStream("application/json");
+      res->print("{\"motors\":[");
+      for (uint8_t i = 0; i < s_motorCount; ++i)
+      {
+        const Stats st = stats(i);
+        res->printf("%s{\"latched\":%s,\"pinLow\":%s,\"count\":%lu,\"glitches\":%lu,\"lastCutNs\":%lu,"
+                    "\"maxCutNs\":%lu,\"lastNoticeUs\":%lu,\"maxNoticeUs\":%lu}",
+                    i ? "," : "", isLatched(i) ? "true" : "false", isPinLow(i) ? "true" : "false",
+                    (unsigned long)st.count, (unsigned long)st.glitches, (unsigned long)cyclesToNs(st.lastCutCycles),
+                    (unsigned long)cyclesToNs(st.maxCutCycles), (unsigned long)st.lastNoticeUs,
+                    (unsigned long)st.maxNoticeUs);
+      }
+      res->print("]}");
+      req->send(res); });
+
+    // Applied by loop() (single producer of motor commands); the result shows up in status
+    server.on("/fault/api/recover", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      requestRecover();
+      req->send(202, "application/json", "{\"ok\":true}"); });
+  }
+} // namespace FaultManager
@@ -0,0 +1,53 @@
+// FaultManager: DRV8874 nFAULT handling with the cut-off in the ISR. The falling edge coasts
+// every motor on that pin straight from the interrupt (GPIO matrix + register writes, no task
+// hop). CONFIRM_US later a one-shot esp_timer re-samples the pin: still low latches and counts
+// the fault, high again was a glitch (EMI from the SSR or the motors) and service() reconnects
+// the outputs. Latched outputs stay cut until an explicit recover() while the pin reads high.
+// Reaction time is measured in CPU cycles from ISR entry to both IN pins low; the delay until
+// loop() noticed the latch is recorded as well.
+// Several motors may share one open-drain nFAULT line (wired-OR): a fault then cuts all of them.
+
+#pragma once
+
+#include <stdint.h>
+
+class AsyncWebServer;
+class DRV8874;
+
+namespace FaultManager
+{
+  constexpr uint8_t MAX_MOTORS = 2;
+  constexpr uint32_t CONFIRM_US = 200; // nFAULT must still be low this long after the edge to latch
+
+  struct Stats
+  {
+    uint32_t count = 0;           // faults since boot
+    uint32_t glitches = 0;        // edges that were high again after CONFIRM_US (not latched)
+    uint32_t lastCutCycles = 0;   // ISR entry → IN pins low, last fault
+    uint32_t maxCutCycles = 0;    // worst case since boot
+    uint32_t lastNoticeUs = 0;    // ISR → loop() service(), last fault
+    uint32_t maxNoticeUs = 0;
+  };
+
+  // Register a motor with its nFAULT pin (active low, pulled up). Motors are indexed in call
+  // order; the same pin may be passed for several motors. Call after motor.begin().
+  void attach(uint8_t faultPin, DRV8874 *motor);
+
+  // Call every loop(): coasts newly latched motors through their command queue (resets the control
+  // state), reconnects the outputs after glitches and applies recovery requests. Returns a bitmask
+  // of motors latched since the last call.
+  uint8_t service();
+
+  bool isLatched(uint8_t motorIdx);
+  uint8_t latchedMask();
+  bool isPinLow(uint8_t motorIdx); // fault still asserted
+  Stats stats(uint8_t motorIdx);
+
+  // Clear all latches and reconnect the outputs, only if no nFAULT pin is still low.
+  // Call from loop() (it posts motor commands); recover() from other tasks goes through requestRecover().
+  bool recover();
+  void requestRecover();
+
+  // GET /fault/api/status, POST /fault/api/recover
+  void attachRoutes(AsyncWebServer &server);
+} // namespace FaultManager
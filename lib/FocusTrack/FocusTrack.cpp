@@ -0,0 +1,86 @@
+// FocusTrack: implementation
+
+#include "FocusTrack.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+namespace
+{
+  Preferences s_prefs;
+  FocusPoint s_points[FocusTrack::MAX_POINTS];
+  uint8_t s_count = 0;
+
+  int32_t absDiff(int32_t a, int32_t b) { return a > b ? a - b : b - a; }
+
+  void persist()
+  {
+    s_prefs.putUChar("n", s_count);
+    if (s_count)
+      s_prefs.putBytes("pts", s_points, sizeof(FocusPoint) * s_count);
+    else
+      s_prefs.remove("pts");
+  }
+
+  void removeAt(uint8_t index)
+  {
+    for (uint8_t i = index; i + 1 < s_count; ++i)
+      s_points[i] = s_points[i + 1];
+    s_count--;
+  }
+} // namespace
+
+namespace FocusTrack
+{
+  void begin()
+  {
+    s_prefs.begin("focus", false);
+    s_count = s_prefs.getUChar("n", 0);
+    if (s_count > MAX_POINTS || s_prefs.getBytes("pts", s_points, sizeof(FocusPoint) * s_count) != sizeof(FocusPoint) * s_count)
+      s_count = 0;
+    Serial.printf("FocusTrack: %u points\n", (unsigned)s_count);
+  }
+
+  uint8_t count() { return s_count; }
+
+  const FocusPoint &point(uint8_t index) { return s_points[index < s_count ? index : 0]; }
+
+  void capture(int32_t head, int32_t lens)
+  {
+    // Drop a point at (nearly) the same magnification, or the nearest one if full
+    int8_t nearest = -1;
+    for (uint8_t i = 0; i < s_count; ++i)
+      if (nearest < 0 || absDiff(s_points[i].head, head) < absDiff(s_points[nearest].head, head))
+        nearest = int8_t(i);
+    if (nearest >= 0 && (absDiff(s_points[nearest].head, head) <= MERGE_COUNTS || s_count >= MAX_POINTS))
+      removeAt(uint8_t(nearest));
+
+    uint8_t pos = s_count;
+    while (pos > 0 && s_points[pos - 1].head > head)
+    {
+      s_points[pos] = s_points[pos - 1];
+      --pos;
+    }
+    s_points[pos].head = head;
+    s_points[pos].lens = lens;
+    s_count++;
+    persist();
+    Serial.printf("FocusTrack: captured head=%ld lens=%ld (%u points)\n", (long)head, (long)lens, (unsigned)s_count);
+  }
+
+  void clear()
+  {
+    s_count = 0;
+    persist();
+    Serial.println("FocusTrack: cleared");
+  }
+
+  bool lensFor(int32_t head, int32_t &lens)
+  {
+    if (s_count < 2)
+      return false;
+    lens = interpolate(s_points, s_count, head);
+    return true;
+  }
+
+} // namespace FocusTrack
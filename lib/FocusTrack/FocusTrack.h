@@ -0,0 +1,50 @@
+// FocusTrack: head position → lens position calibration table for coupled focus.
+// A few (head, lens) points captured in focus at different magnifications, kept sorted by head
+// position and linearly interpolated (clamped to the end points). Persisted in NVS.
+// Positions are DRV8874 ripple counts.
+
+#pragma once
+
+#include <stdint.h>
+
+struct FocusPoint
+{
+  int32_t head = 0;
+  int32_t lens = 0;
+};
+
+namespace FocusTrack
+{
+  constexpr uint8_t MAX_POINTS = 8;
+  constexpr int32_t MERGE_COUNTS = 50; // capture this close to an existing head position replaces it
+
+  // Load the table from NVS (Preferences namespace "focus")
+  void begin();
+
+  uint8_t count();
+  const FocusPoint &point(uint8_t index);
+
+  // Add an in-focus point (sorted insert). Replaces a point within MERGE_COUNTS, or the nearest
+  // one when the table is full.
+  void capture(int32_t head, int32_t lens);
+  void clear();
+
+  // Interpolated lens position for a head position. False with fewer than 2 points.
+  bool lensFor(int32_t head, int32_t &lens);
+
+  // Pure interpolation over a sorted table
+  inline int32_t interpolate(const FocusPoint *pts, uint8_t n, int32_t head)
+  {
+    if (head <= pts[0].head)
+      return pts[0].lens;
+    if (head >= pts[n - 1].head)
+      return pts[n - 1].lens;
+    uint8_t i = 1;
+    while (head > pts[i].head)
+      ++i;
+    const FocusPoint &a = pts[i - 1];
+    const FocusPoint &b = pts[i];
+    return a.lens + int32_t((int64_t(b.lens - a.lens) * (head - a.head)) / (b.head - a.head));
+  }
+
+} // namespace FocusTrack
@@ -113,6 +113,11 @@ namespace BtInput
       agg.l1 |= ctl->l1();
       agg.r2 |= ctl->r2();
       agg.l2 |= ctl->l2();
+      agg.select |= ctl->miscSelect();
+      agg.start |= ctl->miscStart();
+      agg.system |= ctl->miscSystem();
+      agg.thumbL |= ctl->thumbL();
+      agg.thumbR |= ctl->thumbR();
 
       const uint8_t d = ctl->dpad();
 // Use Bluepad32-compatible DPAD bit positions if not provided by headers
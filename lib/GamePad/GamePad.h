@@ -21,6 +21,11 @@ namespace BtInput
     bool l1 = false;
     bool r2 = false;
     bool l2 = false;
+    bool select = false; // PS Share / Create
+    bool start = false;  // PS Options
+    bool system = false; // PS button
+    bool thumbL = false; // L3
+    bool thumbR = false; // R3
   };
 
   // Initializes Bluepad32 and starts scanning for controllers.
@@ -0,0 +1,63 @@
+// Lamp response model: a halogen filament comes up to full output with a first-order rise
+// (time constant riseUs) and glows on after switch-off with a first-order decay (fallUs). Light
+// delivered by an on-time P, in µs of full output:
+//   light(P) = P − (rise − fall) · (1 − e^(−P / rise))
+// Long exposures lose (rise − fall) once; short ones lose relatively more because the filament
+// never reaches full output. pinUsFor() inverts the model so the light matches the requested
+// time across the whole range. Float, so call it from tasks only (not from ISRs).
+
+#pragma once
+#include <math.h>
+#include <stdint.h>
+
+struct LampModel
+{
+    uint16_t riseUs = 0; // 0/0: ideal lamp, light = on-time
+    uint16_t fallUs = 0;
+
+    bool isIdeal() const { return riseUs == 0 && fallUs == 0; }
+
+    // Full-output-equivalent light of an on-time
+    uint64_t lightUs(uint64_t pinUs) const
+    {
+        if (pinUs == 0)
+            return 0;
+        if (riseUs == 0)
+            return pinUs + fallUs;
+        if (pinUs >= LONG_TAUS * riseUs) // settled: exact in integers at any length
+            return clampUs(int64_t(pinUs) - riseUs + fallUs);
+        const float p = float(pinUs);
+        return clampUs(int64_t(lroundf(p - delta() * (1.0f - expf(-p / riseUs)))));
+    }
+
+    // On-time that delivers `light` µs of light (0 if even the shortest pulse gives more)
+    uint64_t pinUsFor(uint64_t light) const
+    {
+        if (light == 0)
+            return 0;
+        if (riseUs == 0)
+            return light > fallUs ? light - fallUs : 0;
+        const int64_t settled = int64_t(light) + riseUs - fallUs;
+        if (settled >= int64_t(LONG_TAUS) * riseUs)
+            return clampUs(settled);
+        // Short exposure: Newton on light(P) − target, monotonic as long as the filament glows on
+        float p = settled > 0 ? float(settled) : 0.0f;
+        for (uint8_t i = 0; i < 8; ++i)
+        {
+            const float e = expf(-p / riseUs);
+            const float f = p - delta() * (1.0f - e) - float(light);
+            const float df = 1.0f - delta() / riseUs * e;
+            p -= f / df;
+            if (p < 1.0f) // light'(0) is 0 without glow: stay off the flat start
+                p = 1.0f;
+        }
+        return uint64_t(lroundf(p));
+    }
+
+private:
+    static constexpr uint32_t LONG_TAUS = 16; // e^-16 < 1e-6: the rise has settled
+
+    float delta() const { return float(riseUs) - float(fallUs); }
+
+    static uint64_t clampUs(int64_t us) { return us < 0 ? 0 : uint64_t(us); }
+};
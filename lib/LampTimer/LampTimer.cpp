@@ -0,0 +1,469 @@
+// LampTimer: implementation
+
+#include "LampTimer.h"
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <Preferences.h>
+#include <esp_timer.h>
+
+#include "SimpleRelay.h"
+#include "ZeroCross.h"
+
+#if __has_include(<driver/gptimer.h>)
+#include <driver/gptimer.h>
+#define LAMPTIMER_HAS_GPTIMER 1
+#else
+#define LAMPTIMER_HAS_GPTIMER 0
+#endif
+
+namespace
+{
+  constexpr uint32_t MIN_ALARM_LEAD_US = 200; // time to arm the alarm before it is due
+  constexpr TickType_t FLASH_WAIT_TICKS = pdMS_TO_TICKS(500); // another writer's NVS/LittleFS write
+
+  SimpleRelay *s_lamp = nullptr;
+  SemaphoreHandle_t s_flashLock = nullptr; // held across flash writes; start() takes it too
+
+  enum class Phase : uint8_t
+  {
+    Idle,
+    WaitOn, // zero-cross mode: lamp on at the next alarm
+    On,
+  };
+
+  // Shared with the alarm and zero-cross ISRs
+  portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+  volatile Phase s_phase = Phase::Idle;
+  volatile bool s_finished = false; // exposure over, not yet reported by pollFinished()
+  uint64_t s_onUs = 0;
+  uint64_t s_offUs = 0;
+
+  // Zero-cross mode: light runs from crossing s_onCrossUs for s_halfCycles half cycles
+  ZeroCrossTracker s_zc;
+  uint8_t s_zcPin = 0;
+  uint64_t s_onCrossUs = 0;
+  uint32_t s_halfCycles = 0; // 0: free-running exposure
+  bool s_offRefined = false;
+  LampTimer::Exposure s_pending; // filled when the exposure ends
+  LampTimer::Exposure s_last;
+
+  LampTimer::Compensation s_comp;
+  LampModel s_model;
+  uint32_t s_seq = 0;
+
+#if LAMPTIMER_HAS_GPTIMER
+  gptimer_handle_t s_timer = nullptr; // free-running 1 MHz, never restarted
+
+  inline uint64_t IRAM_ATTR nowUs()
+  {
+    uint64_t count = 0;
+    gptimer_get_raw_count(s_timer, &count); // allowed from ISRs
+    return count;
+  }
+#else
+  esp_timer_handle_t s_timer = nullptr;
+
+  inline uint64_t nowUs() { return uint64_t(esp_timer_get_time()); }
+#endif
+
+  bool armAlarm(uint64_t atUs);
+
+  // Error of a finished exposure: light through the lamp model − requested. Task context only.
+  LampTimer::Exposure withLightError(LampTimer::Exposure ex, const LampModel &model)
+  {
+    const int64_t err = int64_t(model.lightUs(ex.switchedUs)) - int64_t(ex.requestedUs);
+    ex.errorUs = int32_t(err < INT32_MIN ? INT32_MIN : err > INT32_MAX ? INT32_MAX : err);
+    return ex;
+  }
+
+  // Caller holds s_mux
+  void IRAM_ATTR finishLocked(bool cancelled)
+  {
+    const bool wasOn = s_phase == Phase::On;
+    s_lamp->offFromIsr();
+    s_offUs = nowUs();
+    s_phase = Phase::Idle;
+    s_pending.pinUs = wasOn ? s_offUs - s_onUs : 0;
+    if (!wasOn)
+      s_pending.switchedUs = 0; // cancelled before the first crossing
+    else if (s_halfCycles)
+      // The SSR conducts from the crossing after the on edge to the crossing after the off edge
+      s_pending.switchedUs = s_zc.nextCrossing(s_offUs) - s_onCrossUs;
+    else
+    {
+      const int64_t switchedUs = int64_t(s_pending.pinUs) + s_comp.offLatencyUs - s_comp.onLatencyUs;
+      s_pending.switchedUs = switchedUs > 0 ? uint64_t(switchedUs) : 0;
+    }
+    s_pending.cancelled = cancelled; // errorUs: filled in task context (the lamp model uses float)
+    s_last = s_pending;
+    s_finished = true;
+  }
+
+  // Caller holds s_mux
+  void IRAM_ATTR alarmLocked()
+  {
+    if (s_phase == Phase::WaitOn)
+    {
+      s_lamp->onFromIsr();
+      s_onUs = nowUs();
+      s_phase = Phase::On;
+      // Backstop off from the prediction; the zero-cross ISR re-arms it one half cycle before
+      armAlarm(s_zc.crossingAfterLast(s_zc.halfCyclesSinceLast(s_onCrossUs) + s_halfCycles) - s_zc.config().leadUs);
+    }
+    else if (s_phase == Phase::On) // a cancel() may have won the race
+      finishLocked(false);
+  }
+
+#if LAMPTIMER_HAS_GPTIMER
+  bool IRAM_ATTR onAlarm(gptimer_handle_t, const gptimer_alarm_event_data_t *, void *)
+  {
+    portENTER_CRITICAL_ISR(&s_mux);
+    alarmLocked();
+    portEXIT_CRITICAL_ISR(&s_mux);
+    return false; // no task woken
+  }
+
+  // Detector edge: track the phase and, near the end of an aligned exposure, place the off edge
+  // from the latest crossing rather than a prediction made seconds ago
+  void IRAM_ATTR onZeroCross()
+  {
+    const uint64_t t = nowUs();
+    portENTER_CRITICAL_ISR(&s_mux);
+    if (s_zc.edge(t) && s_phase == Phase::On && s_halfCycles && !s_offRefined)
+    {
+      const uint64_t last = s_zc.lastCrossingUs();
+      const uint32_t done = last > s_onCrossUs ? uint32_t(((last - s_onCrossUs) * 2 + s_zc.halfPeriodUs()) /
+                                                          (2 * s_zc.halfPeriodUs()))
+                                               : 0;
+      if (done + 1 >= s_halfCycles)
+      {
+        const uint32_t left = s_halfCycles > done ? s_halfCycles - done : 0;
+        armAlarm(s_zc.crossingAfterLast(left) - s_zc.config().leadUs);
+        s_offRefined = true;
+      }
+    }
+    portEXIT_CRITICAL_ISR(&s_mux);
+  }
+#else
+  void onAlarm(void *)
+  {
+    portENTER_CRITICAL(&s_mux);
+    alarmLocked();
+    portEXIT_CRITICAL(&s_mux);
+  }
+#endif
+
+  bool IRAM_ATTR armAlarm(uint64_t atUs)
+  {
+#if LAMPTIMER_HAS_GPTIMER
+    gptimer_alarm_config_t alarm = {};
+    alarm.alarm_count = atUs;
+    return gptimer_set_alarm_action(s_timer, &alarm) == ESP_OK;
+#else
+    esp_timer_stop(s_timer);
+    const uint64_t now = nowUs();
+    return esp_timer_start_once(s_timer, atUs > now ? atUs - now : 1) == ESP_OK;
+#endif
+  }
+} // namespace
+
+namespace LampTimer
+{
+  void begin(SimpleRelay *lamp)
+  {
+    s_lamp = lamp;
+    s_flashLock = xSemaphoreCreateMutex();
+
+    Preferences prefs;
+    if (prefs.begin("lamptimer", true))
+    {
+      s_comp.onLatencyUs = prefs.getUShort("onLat", 0);
+      s_comp.offLatencyUs = prefs.getUShort("offLat", 0);
+      s_model.riseUs = prefs.getUShort("riseUs", 0);
+      s_model.fallUs = prefs.getUShort("fallUs", 0);
+      prefs.end();
+    }
+
+#if LAMPTIMER_HAS_GPTIMER
+    gptimer_config_t cfg = {};
+    cfg.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+    cfg.direction = GPTIMER_COUNT_UP;
+    cfg.resolution_hz = 1000000;
+    gptimer_event_callbacks_t cbs = {};
+    cbs.on_alarm = onAlarm;
+    if (gptimer_new_timer(&cfg, &s_timer) != ESP_OK || gptimer_register_event_callbacks(s_timer, &cbs, nullptr) != ESP_OK ||
+        gptimer_enable(s_timer) != ESP_OK || gptimer_start(s_timer) != ESP_OK)
+    {
+      Serial.println("LampTimer: GPTimer setup failed");
+      s_timer = nullptr;
+      return;
+    }
+#else
+    esp_timer_create_args_t args = {};
+    args.callback = onAlarm;
+    args.name = "LampTimer";
+    if (esp_timer_create(&args, &s_timer) != ESP_OK)
+    {
+      Serial.println("LampTimer: esp_timer setup failed");
+      s_timer = nullptr;
+      return;
+    }
+#endif
+    Serial.printf("LampTimer: SSR compensation on=%u us off=%u us, lamp rise=%u us fall=%u us\n", s_comp.onLatencyUs,
+                  s_comp.offLatencyUs, s_model.riseUs, s_model.fallUs);
+  }
+
+  bool start(uint32_t durationMs)
+  {
+    if (!s_lamp || !s_timer)
+      return false;
+    const uint64_t requestedUs = uint64_t(durationMs) * 1000u;
+    const uint64_t switchUs = lampModel().pinUsFor(requestedUs); // SSR conduction for that much light
+    bool ok;
+
+    // A flash write in progress would stall the alarm: let it finish before the lamp goes on
+    if (s_flashLock)
+      xSemaphoreTake(s_flashLock, portMAX_DELAY);
+    portENTER_CRITICAL(&s_mux);
+    s_phase = Phase::Idle; // a late alarm of the previous exposure is now a no-op
+    s_pending = Exposure{};
+    s_pending.seq = ++s_seq;
+    s_pending.requestedUs = requestedUs;
+    const uint64_t now = nowUs();
+    if (s_zcPin && s_zc.locked(now))
+    {
+      // Whole half cycles: on before one crossing, off before the crossing N half cycles later
+      const uint32_t half = s_zc.halfPeriodUs();
+      const uint64_t n = (switchUs + half / 2) / half;
+      s_halfCycles = uint32_t(n ? (n > UINT32_MAX ? UINT32_MAX : n) : 1);
+      s_pending.halfCycles = s_halfCycles;
+      s_onCrossUs = s_zc.nextCrossing(now + s_zc.config().leadUs + MIN_ALARM_LEAD_US);
+      s_offRefined = false;
+      s_phase = Phase::WaitOn;
+      ok = armAlarm(s_onCrossUs - s_zc.config().leadUs);
+    }
+    else
+    {
+      // SSR conducts (off + offLatency) − (on + onLatency): move the off edge by the difference
+      const int64_t pinUs = int64_t(switchUs) + s_comp.onLatencyUs - s_comp.offLatencyUs;
+      s_halfCycles = 0;
+      s_lamp->onFromIsr();
+      s_onUs = now;
+      s_phase = Phase::On;
+      ok = armAlarm(s_onUs + uint64_t(pinUs > 0 ? pinUs : 0));
+    }
+    portEXIT_CRITICAL(&s_mux);
+    if (s_flashLock)
+      xSemaphoreGive(s_flashLock);
+
+    if (!ok)
+    {
+      Serial.println("LampTimer: alarm failed, lamp off");
+      cancel();
+      return false;
+    }
+    return true;
+  }
+
+  void cancel()
+  {
+    portENTER_CRITICAL(&s_mux);
+    if (s_phase != Phase::Idle)
+      finishLocked(true);
+    portEXIT_CRITICAL(&s_mux);
+  }
+
+  void finish()
+  {
+    portENTER_CRITICAL(&s_mux);
+    if (s_phase != Phase::Idle)
+      finishLocked(false);
+    portEXIT_CRITICAL(&s_mux);
+  }
+
+  bool isRunning() { return s_phase != Phase::Idle; }
+
+  bool toggle()
+  {
+    if (!s_lamp)
+      return false;
+    portENTER_CRITICAL(&s_mux);
+    if (s_phase != Phase::Idle)
+      finishLocked(true);
+    else if (s_lamp->isOn())
+      s_lamp->offFromIsr();
+    else
+      s_lamp->onFromIsr();
+    const bool on = s_lamp->isOn();
+    portEXIT_CRITICAL(&s_mux);
+    return on;
+  }
+
+  bool beginFlashWrite()
+  {
+    if (s_flashLock && xSemaphoreTake(s_flashLock, FLASH_WAIT_TICKS) != pdTRUE)
+      return false;
+    if (isRunning())
+    {
+      endFlashWrite();
+      return false;
+    }
+    return true;
+  }
+
+  void endFlashWrite()
+  {
+    if (s_flashLock)
+      xSemaphoreGive(s_flashLock);
+  }
+
+  bool setZeroCross(uint8_t pin, const ZeroCrossConfig &cfg)
+  {
+#if LAMPTIMER_HAS_GPTIMER
+    if (!s_timer)
+      return false;
+    portENTER_CRITICAL(&s_mux);
+    s_zc.configure(cfg);
+    portEXIT_CRITICAL(&s_mux);
+    s_zcPin = pin;
+    pinMode(pin, INPUT); // detector output, external pull-up (GPIO34-39 have none)
+    attachInterrupt(digitalPinToInterrupt(pin), onZeroCross, RISING);
+    Serial.printf("LampTimer: zero-cross input on GPIO%u (%u Hz)\n", pin, cfg.mainsHz);
+    return true;
+#else
+    Serial.println("LampTimer: zero-cross alignment needs GPTimer");
+    return false;
+#endif
+  }
+
+  bool zeroCrossLocked()
+  {
+    portENTER_CRITICAL(&s_mux);
+    const bool locked = s_zcPin && s_zc.locked(nowUs());
+    portEXIT_CRITICAL(&s_mux);
+    return locked;
+  }
+
+  uint32_t halfPeriodUs()
+  {
+    portENTER_CRITICAL(&s_mux);
+    const uint32_t half = s_zc.halfPeriodUs();
+    portEXIT_CRITICAL(&s_mux);
+    return half;
+  }
+
+  bool pollFinished(Exposure &out)
+  {
+    if (!s_finished)
+      return false;
+    portENTER_CRITICAL(&s_mux);
+    out = s_last;
+    const LampModel model = s_model;
+    s_finished = false;
+    portEXIT_CRITICAL(&s_mux);
+    out = withLightError(out, model);
+    return true;
+  }
+
+  Exposure last()
+  {
+    portENTER_CRITICAL(&s_mux);
+    const Exposure ex = s_last;
+    const LampModel model = s_model;
+    portEXIT_CRITICAL(&s_mux);
+    return withLightError(ex, model);
+  }
+
+  Compensation compensation()
+  {
+    portENTER_CRITICAL(&s_mux);
+    const Compensation comp = s_comp;
+    portEXIT_CRITICAL(&s_mux);
+    return comp;
+  }
+
+  bool setCompensation(const Compensation &comp)
+  {
+    if (!beginFlashWrite())
+      return false;
+    portENTER_CRITICAL(&s_mux);
+    s_comp = comp;
+    portEXIT_CRITICAL(&s_mux);
+
+    Preferences prefs;
+    if (prefs.begin("lamptimer", false))
+    {
+      prefs.putUShort("onLat", comp.onLatencyUs);
+      prefs.putUShort("offLat", comp.offLatencyUs);
+      prefs.end();
+    }
+    endFlashWrite();
+    return true;
+  }
+
+  LampModel lampModel()
+  {
+    portENTER_CRITICAL(&s_mux);
+    const LampModel model = s_model;
+    portEXIT_CRITICAL(&s_mux);
+    return model;
+  }
+
+  bool setLampModel(const LampModel &model)
+  {
+    if (!beginFlashWrite())
+      return false;
+    portENTER_CRITICAL(&s_mux);
+    s_model = model;
+    portEXIT_CRITICAL(&s_mux);
+
+    Preferences prefs;
+    if (prefs.begin("lamptimer", false))
+    {
+      prefs.putUShort("riseUs", model.riseUs);
+      prefs.putUShort("fallUs", model.fallUs);
+      prefs.end();
+    }
+    endFlashWrite();
+    return true;
+  }
+
+  void attachRoutes(AsyncWebServer &server)
+  {
+    server.on("/lamp/api/exposure", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      const Exposure ex = last();
+      const Compensation comp = compensation();
+      const LampModel model = lampModel();
+      AsyncResponseStream *res = req->beginResponseStream("application/json");
+      res->printf("{\"seq\":%lu,\"requestedUs\":%llu,\"pinUs\":%llu,\"switchedUs\":%llu,\"errorUs\":%ld,"
+                  "\"halfCycles\":%lu,\"cancelled\":%s,\"running\":%s,\"onLatencyUs\":%u,\"offLatencyUs\":%u,"
+                  "\"riseUs\":%u,\"fallUs\":%u,\"zcLocked\":%s,\"halfPeriodUs\":%lu}",
+                  (unsigned long)ex.seq, (unsigned long long)ex.requestedUs, (unsigned long long)ex.pinUs,
+                  (unsigned long long)ex.switchedUs, (long)ex.errorUs, (unsigned long)ex.halfCycles,
+                  ex.cancelled ? "true" : "false", isRunning() ? "true" : "false", comp.onLatencyUs, comp.offLatencyUs,
+                  model.riseUs, model.fallUs, zeroCrossLocked() ? "true" : "false", (unsigned long)halfPeriodUs());
+      req->send(res); });
+
+    server.on("/lamp/api/compensation", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      Compensation comp = compensation();
+      if (req->hasParam("on"))
+        comp.onLatencyUs = uint16_t(constrain(req->getParam("on")->value().toInt(), 0L, 20000L));
+      if (req->hasParam("off"))
+        comp.offLatencyUs = uint16_t(constrain(req->getParam("off")->value().toInt(), 0L, 20000L));
+      if (!setCompensation(comp)) { req->send(409, "text/plain", "exposure running"); return; }
+      req->send(200, "application/json", "{\"ok\":true}"); });
+
+    server.on("/lamp/api/model", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      LampModel model = lampModel();
+      if (req->hasParam("rise"))
+        model.riseUs = uint16_t(constrain(req->getParam("rise")->value().toInt(), 0L, 65535L));
+      if (req->hasParam("fall"))
+        model.fallUs = uint16_t(constrain(req->getParam("fall")->value().toInt(), 0L, 65535L));
+      if (!setLampModel(model)) { req->send(409, "text/plain", "exposure running"); return; }
+      req->send(200, "application/json", "{\"ok\":true}"); });
+  }
+} // namespace LampTimer
@@ -0,0 +1,89 @@
+// LampTimer: exposure cut-off from a hardware timer ISR. The lamp is switched on in start(), and
+// a GPTimer alarm switches it off with a direct GPIO register write (SimpleRelay::offFromIsr), so
+// WiFi/BT load and task scheduling no longer land in the print exposure. Both edges are
+// timestamped on the same 1 MHz timer; every exposure reports its measured length and error.
+// Optional SSR compensation: fixed delays from the pin edge to the light turning on / off
+// (stored in NVS) shift the off edge so the light, not the pin, lasts the requested time.
+// Optional lamp model (LampModel.h, NVS): filament rise and glow time constants; the on-time is
+// stretched or shortened so the light equals the requested time from 0.1 s to 9999 s.
+// Without GPTimer (ESP-IDF 4 / Arduino-ESP32 2.x) the alarm runs from esp_timer (task context).
+// The prebuilt Arduino core doesn't set CONFIG_GPTIMER_ISR_IRAM_SAFE, so a flash write (cache
+// off) would hold the alarm back: writers go through beginFlashWrite(), refused during exposures.
+// Zero-cross SSRs only switch at mains crossings: with a zero-cross detector input (setZeroCross)
+// and a locked phase, start and end are aligned to predicted crossings so the light lasts a whole
+// number of half cycles; the SSR latency compensation is not used then.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "LampModel.h"
+#include "ZeroCross.h"
+
+class AsyncWebServer;
+class SimpleRelay;
+
+namespace LampTimer
+{
+  struct Compensation
+  {
+    uint16_t onLatencyUs = 0;  // pin high → light on (zero-cross SSRs: up to a half cycle)
+    uint16_t offLatencyUs = 0; // pin low → light off
+  };
+
+  struct Exposure
+  {
+    uint32_t seq = 0;         // exposures since boot
+    uint64_t requestedUs = 0; // light time asked for
+    uint64_t pinUs = 0;       // measured pin on → off
+    uint64_t switchedUs = 0;  // SSR conduction: pin time corrected by the latencies, or half cycles
+    int32_t errorUs = 0;      // light (switched time through the lamp model) − requested
+    uint32_t halfCycles = 0;  // zero-cross aligned: light in mains half cycles (0: free-running)
+    bool cancelled = false;   // cut short by cancel()
+  };
+
+  // Loads the compensation from NVS and sets up the timer. Call once after lamp.begin().
+  void begin(SimpleRelay *lamp);
+
+  // Lamp on now (zero-cross mode: at the next crossing), off after durationMs of light.
+  // Restarts a running exposure. Call from loop.
+  bool start(uint32_t durationMs);
+
+  // Lamp off now; the exposure is reported as cancelled
+  void cancel();
+
+  // Lamp off now as the regular end of the exposure (e.g. the light meter reached its dose).
+  // Safe from any task.
+  void finish();
+
+  bool isRunning();
+
+  // Manual lamp switch (focusing, metering the reference). Switching off ends a running exposure
+  // as cancelled. Returns the new lamp state. Call from loop.
+  bool toggle();
+
+  // Bracket every NVS/LittleFS write: false while an exposure runs (write it later or refuse),
+  // otherwise start() waits for endFlashWrite(). Any task.
+  bool beginFlashWrite();
+  void endFlashWrite();
+
+  // Optional zero-cross detector (one rising edge per mains crossing). Exposures align to the
+  // crossings once the phase is locked and fall back to free-running timing otherwise.
+  bool setZeroCross(uint8_t pin, const ZeroCrossConfig &cfg = ZeroCrossConfig());
+  bool zeroCrossLocked();
+  uint32_t halfPeriodUs();
+
+  // True once per finished (or cancelled) exposure, with its measurement. Call from loop.
+  bool pollFinished(Exposure &out);
+  Exposure last();
+
+  Compensation compensation();
+  bool setCompensation(const Compensation &comp); // applies from the next start(), persisted; false while exposing
+
+  LampModel lampModel();
+  bool setLampModel(const LampModel &model); // applies from the next start(), persisted; false while exposing
+
+  // GET /lamp/api/exposure (last exposure, compensation, lamp model),
+  // POST /lamp/api/compensation?on=&off= (µs), POST /lamp/api/model?rise=&fall= (µs)
+  void attachRoutes(AsyncWebServer &server);
+} // namespace LampTimer
@@ -0,0 +1,102 @@
+// Mains phase tracker for zero-cross SSR switching. Fed with the timestamps of a zero-cross
+// detector (one edge per crossing, i.e. per half cycle), it tracks the half period with a
+// fixed-point IIR, rejects bounce and bridges missed edges, and predicts future crossings.
+
+#pragma once
+#include <stdint.h>
+
+struct ZeroCrossConfig
+{
+    uint8_t mainsHz = 50;         // nominal mains frequency (50 / 60)
+    uint8_t tolerancePct = 10;    // an edge interval may deviate this much from the tracked half period
+    int16_t detectorOffsetUs = 0; // true crossing = detector edge + offset (detector phase shift)
+    uint8_t lockEdges = 16;       // consecutive good intervals before predictions are used
+    uint16_t leadUs = 500;        // switch the SSR input this long before the target crossing
+};
+
+class ZeroCrossTracker
+{
+public:
+    void configure(const ZeroCrossConfig &cfg)
+    {
+        _cfg = cfg;
+        reset();
+    }
+
+    void reset()
+    {
+        _halfQ8 = (500000u / (_cfg.mainsHz ? _cfg.mainsHz : 50)) << 8;
+        _good = 0;
+        _have = false;
+    }
+
+    // Detector edge at tUs (monotonic µs). False if rejected as bounce or out of phase.
+    bool edge(uint64_t tUs)
+    {
+        const uint64_t t = tUs + int64_t(_cfg.detectorOffsetUs);
+        if (!_have)
+        {
+            _last = t;
+            _have = true;
+            return true;
+        }
+        const uint32_t half = _halfQ8 >> 8;
+        const uint32_t tol = (half * _cfg.tolerancePct) / 100u;
+        const uint64_t dt = t - _last;
+        if (dt + tol < half)
+            return false; // bounce / noise: keep the previous crossing
+        const uint32_t k = uint32_t((dt + half / 2) / half); // half cycles spanned (> 1: missed edges)
+        const int64_t err = int64_t(dt) - int64_t(k) * half;
+        _last = t;
+        if (k > MAX_BRIDGED || err > int64_t(tol) || err < -int64_t(tol))
+        {
+            _good = 0; // lost: restart lock from this edge
+            return false;
+        }
+        const int32_t measuredQ8 = int32_t((dt << 8) / k);
+        _halfQ8 = uint32_t(int32_t(_halfQ8) + (measuredQ8 - int32_t(_halfQ8)) / 16);
+        if (_good < 255)
+            _good++;
+        return true;
+    }
+
+    // Locked and edges still arriving at nowUs
+    bool locked(uint64_t nowUs) const
+    {
+        return _have && _good >= _cfg.lockEdges && nowUs - _last < uint64_t(MAX_BRIDGED) * (_halfQ8 >> 8);
+    }
+
+    uint32_t halfPeriodUs() const { return _halfQ8 >> 8; }
+    uint64_t lastCrossingUs() const { return _last; }
+
+    // Half cycles from the last crossing to the crossing nearest tUs
+    uint32_t halfCyclesSinceLast(uint64_t tUs) const
+    {
+        return tUs <= _last ? 0 : uint32_t((((tUs - _last) << 8) + _halfQ8 / 2) / _halfQ8);
+    }
+
+    // n half cycles after the last crossing
+    uint64_t crossingAfterLast(uint32_t n) const { return _last + ((uint64_t(n) * _halfQ8) >> 8); }
+
+    // First predicted crossing at or after tUs
+    uint64_t nextCrossing(uint64_t tUs) const
+    {
+        if (tUs <= _last)
+            return _last;
+        uint32_t n = uint32_t(((tUs - _last) << 8) / _halfQ8);
+        while (crossingAfterLast(n) < tUs)
+            n++;
+        return crossingAfterLast(n);
+    }
+
+    const ZeroCrossConfig &config() const { return _cfg; }
+
+private:
+    static constexpr uint32_t MAX_BRIDGED = 4; // missed edges bridged in a row
+
+    ZeroCrossConfig _cfg;
+    uint32_t _halfQ8 = 10000u << 8;
+    uint64_t _last = 0;
+    uint8_t _good = 0;
+    bool _have = false;
+};
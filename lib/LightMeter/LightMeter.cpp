@@ -0,0 +1,218 @@
+// LightMeter: implementation
+
+#include "LightMeter.h"
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <Preferences.h>
+
+#include "AdcStream.h"
+#include "LampTimer.h"
+
+namespace
+{
+  constexpr uint8_t DOSE_FRAC_BITS = 24; // dose accumulator: reference µs in Q24
+  constexpr uint8_t LEVEL_SHIFT = 6;     // level IIR over 64 samples (~6 ms at 10 kHz)
+  constexpr uint16_t MIN_SPAN_Q4 = 16 * 16; // reference at least 16 counts above dark
+
+  int8_t s_slot = -1;
+  LightMeter::Calibration s_cal;
+
+  // Reader task only
+  uint32_t s_levelAcc = 0; // level in Q4 << LEVEL_SHIFT
+
+  // Shared between loop (start/stop) and the reader task (sink)
+  portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+  volatile bool s_armed = false;
+  bool s_reached = false;
+  uint16_t s_darkQ4 = 0;      // dark point of the running exposure
+  uint32_t s_weightQ24 = 0;   // reference µs per Q4 count above dark per sample, Q24
+  uint64_t s_doseQ24 = 0;
+  uint64_t s_targetQ24 = 0;
+  uint64_t s_targetUs = 0;
+  uint32_t s_tailUs = 0;        // light expected after the cut, in µs at the level of the cut
+  uint32_t s_tailSamplesQ8 = 0; // the same in samples, Q8
+
+  // Reader task, every conversion of the photodiode pin
+  void onSample(void *, uint16_t raw)
+  {
+    const uint32_t xQ4 = uint32_t(raw) << 4;
+    s_levelAcc += xQ4 - (s_levelAcc >> LEVEL_SHIFT);
+    if (!s_armed)
+      return;
+
+    bool cut = false;
+    portENTER_CRITICAL(&s_mux);
+    if (s_armed)
+    {
+      if (xQ4 > s_darkQ4)
+        s_doseQ24 += uint64_t(xQ4 - s_darkQ4) * s_weightQ24;
+      // Light still comes after the cut (SSR turn-off, filament afterglow): cut early by that
+      // much at the current smoothed level
+      const uint32_t levelQ4 = s_levelAcc >> LEVEL_SHIFT;
+      const uint64_t tailQ24 =
+          levelQ4 > s_darkQ4 ? (uint64_t(levelQ4 - s_darkQ4) * s_weightQ24 * s_tailSamplesQ8) >> 8 : 0;
+      if (s_doseQ24 + tailQ24 >= s_targetQ24)
+      {
+        s_armed = false;
+        s_reached = cut = true;
+      }
+    }
+    portEXIT_CRITICAL(&s_mux);
+    if (cut)
+      LampTimer::finish();
+  }
+
+  // Applies cal once it is stored; false while an exposure runs (no flash writes then)
+  bool saveCalibration(const LightMeter::Calibration &cal)
+  {
+    if (!LampTimer::beginFlashWrite())
+      return false;
+    Preferences prefs;
+    if (prefs.begin("lightmeter", false))
+    {
+      prefs.putUShort("dark", cal.darkQ4);
+      prefs.putUShort("ref", cal.refQ4);
+      prefs.end();
+    }
+    LampTimer::endFlashWrite();
+    s_cal = cal;
+    return true;
+  }
+} // namespace
+
+namespace LightMeter
+{
+  bool begin(uint8_t pin)
+  {
+    Preferences prefs;
+    if (prefs.begin("lightmeter", true))
+    {
+      s_cal.darkQ4 = prefs.getUShort("dark", 0);
+      s_cal.refQ4 = prefs.getUShort("ref", 0);
+      prefs.end();
+    }
+
+    const int8_t slot = AdcStream::attach(pin);
+    if (slot < 0 || !AdcStream::setSampleSink(slot, onSample, nullptr))
+    {
+      Serial.printf("LightMeter: pin %u unusable (needs the continuous ADC driver)\n", (unsigned)pin);
+      return false;
+    }
+    s_slot = slot;
+    Serial.printf("LightMeter: pin %u, %lu Hz, dark=%u ref=%u (Q4 counts)\n", (unsigned)pin,
+                  (unsigned long)AdcStream::perPinRateHz(), s_cal.darkQ4, s_cal.refQ4);
+    return true;
+  }
+
+  bool isAttached() { return s_slot >= 0; }
+
+  uint16_t levelQ4() { return uint16_t(s_levelAcc >> LEVEL_SHIFT); }
+
+  uint16_t relativePct()
+  {
+    if (!isCalibrated())
+      return 0;
+    const uint16_t level = levelQ4();
+    return level > s_cal.darkQ4 ? uint16_t(uint32_t(level - s_cal.darkQ4) * 100u / (s_cal.refQ4 - s_cal.darkQ4)) : 0;
+  }
+
+  Calibration calibration() { return s_cal; }
+
+  bool isCalibrated() { return s_cal.refQ4 >= s_cal.darkQ4 + MIN_SPAN_Q4; }
+
+  bool calibrateDark()
+  {
+    Calibration cal = s_cal;
+    cal.darkQ4 = levelQ4();
+    if (!isAttached() || !saveCalibration(cal))
+      return false;
+    Serial.printf("LightMeter: dark=%u\n", s_cal.darkQ4);
+    return true;
+  }
+
+  bool calibrateReference()
+  {
+    const uint16_t level = levelQ4();
+    Calibration cal = s_cal;
+    cal.refQ4 = level;
+    if (!isAttached() || level < s_cal.darkQ4 + MIN_SPAN_Q4 || !saveCalibration(cal))
+      return false;
+    Serial.printf("LightMeter: ref=%u\n", s_cal.refQ4);
+    return true;
+  }
+
+  bool start(uint32_t targetMs)
+  {
+    const uint32_t rateHz = AdcStream::perPinRateHz();
+    if (!isAttached() || !isCalibrated() || rateHz == 0)
+      return false;
+    // One sample stands for 1/rate s of light; at the reference level it adds 1e6/rate ref µs
+    const uint32_t weightQ24 =
+        uint32_t((uint64_t(1000000) << DOSE_FRAC_BITS) / (uint64_t(rateHz) * (s_cal.refQ4 - s_cal.darkQ4)));
+    // After finish() the lamp glows on for fallUs; a zero-cross SSR also conducts until the next
+    // crossing (half a half cycle on average), a random-fire one for its off latency
+    const uint32_t tailUs = LampTimer::lampModel().fallUs + (LampTimer::zeroCrossLocked()
+                                                                 ? LampTimer::halfPeriodUs() / 2
+                                                                 : LampTimer::compensation().offLatencyUs);
+    const uint32_t tailSamplesQ8 = uint32_t(((uint64_t(tailUs) * rateHz) << 8) / 1000000u);
+    portENTER_CRITICAL(&s_mux);
+    s_darkQ4 = s_cal.darkQ4;
+    s_weightQ24 = weightQ24;
+    s_targetUs = uint64_t(targetMs) * 1000u;
+    s_targetQ24 = uint64_t(s_targetUs) << DOSE_FRAC_BITS;
+    s_tailUs = tailUs;
+    s_tailSamplesQ8 = tailSamplesQ8;
+    s_doseQ24 = 0;
+    s_reached = false;
+    s_armed = true;
+    portEXIT_CRITICAL(&s_mux);
+    return true;
+  }
+
+  void stop()
+  {
+    portENTER_CRITICAL(&s_mux);
+    s_armed = false;
+    portEXIT_CRITICAL(&s_mux);
+  }
+
+  Dose dose()
+  {
+    Dose d;
+    portENTER_CRITICAL(&s_mux);
+    d.targetUs = s_targetUs;
+    d.doseUs = s_doseQ24 >> DOSE_FRAC_BITS;
+    d.tailUs = s_tailUs;
+    d.armed = s_armed;
+    d.reached = s_reached;
+    portEXIT_CRITICAL(&s_mux);
+    return d;
+  }
+
+  void attachRoutes(AsyncWebServer &server)
+  {
+    server.on("/meter/api/status", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      const Dose d = dose();
+      AsyncResponseStream *res = req->beginResponseStream("application/json");
+      res->printf("{\"attached\":%s,\"levelQ4\":%u,\"darkQ4\":%u,\"refQ4\":%u,\"relativePct\":%u,\"calibrated\":%s,"
+                  "\"armed\":%s,\"reached\":%s,\"targetUs\":%llu,\"doseUs\":%llu,\"tailUs\":%lu}",
+                  isAttached() ? "true" : "false", levelQ4(), s_cal.darkQ4, s_cal.refQ4, relativePct(),
+                  isCalibrated() ? "true" : "false", d.armed ? "true" : "false", d.reached ? "true" : "false",
+                  (unsigned long long)d.targetUs, (unsigned long long)d.doseUs, (unsigned long)d.tailUs);
+      req->send(res); });
+
+    server.on("/meter/api/calibrate", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      const String point = req->hasParam("point") ? req->getParam("point")->value() : String();
+      bool ok;
+      if (point == "dark")
+        ok = calibrateDark();
+      else if (point == "ref")
+        ok = calibrateReference();
+      else { req->send(400, "text/plain", "point=dark|ref"); return; }
+      if (!ok) { req->send(409, "text/plain", "no meter, reference not above dark, or exposure running"); return; }
+      req->send(200, "application/json", "{\"ok\":true}"); });
+  }
+} // namespace LightMeter
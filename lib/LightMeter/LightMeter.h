@@ -0,0 +1,60 @@
+// LightMeter: integrating exposures from a photodiode under the lens. The photodiode amplifier
+// output is one more AdcStream pin; a sample sink integrates every conversion (kHz per pin) into a
+// fixed-point dose and ends the LampTimer exposure once the dose plus the light still expected
+// after the cut (afterglow, SSR turn-off) reaches the target, so lamp drift (mains voltage, bulb
+// age, warm-up) no longer changes the print density.
+// The dose unit is "reference microseconds": light at the calibrated reference level for 1 µs.
+// A metered exposure of T ms therefore gives the same density as a T ms timed exposure at the
+// reference level. Two calibration points, stored in NVS: dark (lamp off) and reference (lamp on,
+// with the negative and aperture used for printing).
+// Needs the continuous ADC driver (Arduino-ESP32 3.x): the polling fallback has no sample sink.
+
+#pragma once
+
+#include <stdint.h>
+
+class AsyncWebServer;
+
+namespace LightMeter
+{
+  struct Calibration
+  {
+    uint16_t darkQ4 = 0; // raw 12-bit counts in Q4
+    uint16_t refQ4 = 0;
+  };
+
+  struct Dose
+  {
+    uint64_t targetUs = 0; // reference microseconds asked for
+    uint64_t doseUs = 0;   // integrated so far / at the end (light after the cut not included)
+    uint32_t tailUs = 0;   // expected light after the cut, at the level of the cut; cut this early
+    bool armed = false;    // integrating, the lamp is cut at the target
+    bool reached = false;  // the meter ended the exposure
+  };
+
+  // Attach the photodiode pin to AdcStream (after the motors: attaching restarts the sampler) and
+  // load the calibration. False if the pin is unusable or there is no continuous ADC driver.
+  bool begin(uint8_t pin);
+  bool isAttached();
+
+  // Smoothed level in Q4 counts (~10 ms time constant)
+  uint16_t levelQ4();
+  // Current light relative to the reference, in % (0: not calibrated)
+  uint16_t relativePct();
+
+  Calibration calibration();
+  bool isCalibrated();
+  // Take the current level as the dark / reference point and persist it. False if the reference
+  // isn't clearly above dark, or during an exposure (the lamp switch is fine for the reference).
+  bool calibrateDark();
+  bool calibrateReference();
+
+  // Arm integration for targetMs at the reference level; call right before LampTimer::start with
+  // the safety maximum. The dose is counted from zero. False if not attached or calibrated.
+  bool start(uint32_t targetMs);
+  void stop(); // disarm, keeps the dose for reading
+  Dose dose();
+
+  // GET /meter/api/status, POST /meter/api/calibrate?point=dark|ref
+  void attachRoutes(AsyncWebServer &server);
+} // namespace LightMeter
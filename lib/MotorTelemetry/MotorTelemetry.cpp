@@ -0,0 +1,324 @@
+// MotorTelemetry: implementation
+
+#include "MotorTelemetry.h"
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include <new>
+
+#include "DRV8874.h"
+
+namespace
+{
+  constexpr BaseType_t CORE_APP = 1;
+  constexpr UBaseType_t PRIO_SAMPLER = tskIDLE_PRIORITY + 1; // below the motor control tasks
+
+  const DRV8874 *s_motors[2] = {nullptr, nullptr};
+  TelemetryRecord *s_buf = nullptr;
+  TaskHandle_t s_task = nullptr;
+
+  std::atomic<MotorTelemetry::State> s_state{MotorTelemetry::State::Idle};
+  std::atomic<uint8_t> s_pending{0}; // trigger reasons reported since the last sample
+  std::atomic<uint8_t> s_armMask{0}; // != 0: arm() requested, applied by the sampler task
+  std::atomic<uint8_t> s_downloads{0}; // responses still streaming from s_buf (AsyncTCP task)
+  uint8_t s_mask = 0;
+
+  // Sampler task state (read by the web handlers only once Done)
+  uint16_t s_head = 0;  // next write index
+  uint16_t s_count = 0; // valid records (saturates at CAPACITY)
+  uint16_t s_postRemaining = 0;
+  int8_t s_prevDir[2] = {0, 0};
+  TelemetryHeader s_header;
+
+  void sampleOnce()
+  {
+    TelemetryRecord rec{};
+    rec.tUs = micros();
+    bool started = false;
+    for (uint8_t i = 0; i < 2; ++i)
+    {
+      const MotorStatus st = s_motors[i]->getStatus();
+      const uint32_t mA = s_motors[i]->getCurrentmA(); // live: the snapshot is stale while the task idles
+      rec.duty[i] = int16_t(int32_t(st.dutyCmd) * st.dir);
+      rec.mA[i] = uint16_t(mA > UINT16_MAX ? UINT16_MAX : mA);
+      rec.state[i] = uint8_t(st.state);
+      started |= (s_prevDir[i] == 0 && st.dir != 0);
+      s_prevDir[i] = st.dir;
+    }
+    if (started)
+      s_pending.fetch_or(MotorTelemetry::TRIG_START);
+
+    const uint8_t hit = s_pending.exchange(0) & s_mask;
+    if (s_state.load() == MotorTelemetry::State::Armed && hit)
+    {
+      const uint16_t pre = s_count < MotorTelemetry::PRE_TRIGGER ? s_count : MotorTelemetry::PRE_TRIGGER;
+      s_postRemaining = MotorTelemetry::CAPACITY - pre; // including this sample
+      s_header.triggerIndex = pre;
+      s_header.triggerReason = uint8_t(hit & -hit); // lowest set bit
+      rec.flags = 0x01;
+      s_state.store(MotorTelemetry::State::Capturing);
+    }
+
+    s_buf[s_head] = rec;
+    s_head = (s_head + 1) % MotorTelemetry::CAPACITY;
+    if (s_count < MotorTelemetry::CAPACITY)
+      s_count++;
+
+    if (s_state.load() == MotorTelemetry::State::Capturing && --s_postRemaining == 0)
+    {
+      s_header.sampleHz = MotorTelemetry::SAMPLE_HZ;
+      s_header.count = s_count;
+      s_state.store(MotorTelemetry::State::Done);
+      Serial.printf("MotorTelemetry: capture done (%u samples, trigger 0x%02x)\n", (unsigned)s_count, s_header.triggerReason);
+    }
+  }
+
+  void samplerTaskEntry(void *)
+  {
+    TickType_t period = pdMS_TO_TICKS(1000 / MotorTelemetry::SAMPLE_HZ);
+    if (period == 0)
+      period = 1;
+    TickType_t lastWake = xTaskGetTickCount();
+
+    for (;;)
+    {
+      const uint8_t armMask = s_armMask.exchange(0);
+      if (armMask) // reset in the owning task, never under a running sample
+      {
+        s_mask = armMask;
+        s_head = 0;
+        s_count = 0;
+        s_prevDir[0] = s_motors[0]->getStatus().dir; // already running: not a start
+        s_prevDir[1] = s_motors[1]->getStatus().dir;
+        s_pending.store(0);
+        s_header = TelemetryHeader{};
+        s_state.store(MotorTelemetry::State::Armed);
+        lastWake = xTaskGetTickCount();
+      }
+
+      const MotorTelemetry::State st = s_state.load();
+      if (st == MotorTelemetry::State::Idle || st == MotorTelemetry::State::Done)
+      {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // arm() wakes us
+        lastWake = xTaskGetTickCount();
+        continue;
+      }
+      sampleOnce();
+      vTaskDelayUntil(&lastWake, period);
+    }
+  }
+
+  // Oldest first; only valid once Done (the ring is full then)
+  const TelemetryRecord &recordAt(uint16_t i)
+  {
+    return s_buf[(s_head + i) % MotorTelemetry::CAPACITY];
+  }
+
+  // CSV with fixed-width rows so any byte offset maps to a row without extra state
+  const char CSV_HEADER[] = "t_us,m1_duty,m2_duty,m1_mA,m2_mA,m1_state,m2_state,trigger\n";
+  constexpr size_t CSV_HEADER_LEN = sizeof(CSV_HEADER) - 1;
+  constexpr size_t CSV_ROW_LEN = 41; // "%010lu,%+05d,%+05d,%05u,%05u,%1u,%1u,%1u\n"
+
+  void formatCsvRow(uint16_t i, char (&row)[CSV_ROW_LEN + 1])
+  {
+    const TelemetryRecord &r = recordAt(i);
+    snprintf(row, sizeof(row), "%010lu,%+05d,%+05d,%05u,%05u,%1u,%1u,%1u\n",
+             (unsigned long)(r.tUs - recordAt(0).tUs), (int)r.duty[0], (int)r.duty[1],
+             (unsigned)r.mA[0], (unsigned)r.mA[1], (unsigned)(r.state[0] % 10), (unsigned)(r.state[1] % 10),
+             (unsigned)(r.flags & 0x01));
+  }
+
+  size_t fillCsv(uint8_t *buf, size_t maxLen, size_t index)
+  {
+    size_t written = 0;
+    char row[CSV_ROW_LEN + 1];
+    while (written < maxLen)
+    {
+      const size_t pos = index + written;
+      const char *src;
+      size_t off;
+      size_t len;
+      if (pos < CSV_HEADER_LEN)
+      {
+        src = CSV_HEADER;
+        off = pos;
+        len = CSV_HEADER_LEN;
+      }
+      else
+      {
+        const size_t r = (pos - CSV_HEADER_LEN) / CSV_ROW_LEN;
+        if (r >= s_header.count)
+          break;
+        formatCsvRow(uint16_t(r), row);
+        src = row;
+        off = (pos - CSV_HEADER_LEN) % CSV_ROW_LEN;
+        len = CSV_ROW_LEN;
+      }
+      const size_t n = (len - off < maxLen - written) ? len - off : maxLen - written;
+      memcpy(buf + written, src + off, n);
+      written += n;
+    }
+    return written;
+  }
+
+  size_t fillBin(uint8_t *buf, size_t maxLen, size_t index)
+  {
+    size_t written = 0;
+    while (written < maxLen)
+    {
+      const size_t pos = index + written;
+      const uint8_t *src;
+      size_t off;
+      size_t len;
+      if (pos < sizeof(TelemetryHeader))
+      {
+        src = reinterpret_cast<const uint8_t *>(&s_header);
+        off = pos;
+        len = sizeof(TelemetryHeader);
+      }
+      else
+      {
+        const size_t r = (pos - sizeof(TelemetryHeader)) / sizeof(TelemetryRecord);
+        if (r >= s_header.count)
+          break;
+        src = reinterpret_cast<const uint8_t *>(&recordAt(uint16_t(r)));
+        off = (pos - sizeof(TelemetryHeader)) % sizeof(TelemetryRecord);
+        len = sizeof(TelemetryRecord);
+      }
+      const size_t n = (len - off < maxLen - written) ? len - off : maxLen - written;
+      memcpy(buf + written, src + off, n);
+      written += n;
+    }
+    return written;
+  }
+
+  // Counts a download of the frozen capture until its connection closes; arm() refuses meanwhile
+  bool beginDownload(AsyncWebServerRequest *req)
+  {
+    s_downloads.fetch_add(1);
+    if (s_state.load() != MotorTelemetry::State::Done)
+    {
+      s_downloads.fetch_sub(1);
+      return false;
+    }
+    req->onDisconnect([]()
+                      { s_downloads.fetch_sub(1); });
+    return true;
+  }
+
+  const char *stateName(MotorTelemetry::State st)
+  {
+    switch (st)
+    {
+    case MotorTelemetry::State::Armed:
+      return "armed";
+    case MotorTelemetry::State::Capturing:
+      return "capturing";
+    case MotorTelemetry::State::Done:
+      return "done";
+    default:
+      return "idle";
+    }
+  }
+} // namespace
+
+namespace MotorTelemetry
+{
+  void begin(const DRV8874 *motor1, const DRV8874 *motor2)
+  {
+    s_motors[0] = motor1;
+    s_motors[1] = motor2;
+    if (!s_buf)
+      s_buf = new (std::nothrow) TelemetryRecord[CAPACITY];
+    if (!s_buf)
+    {
+      Serial.println("MotorTelemetry: buffer allocation failed");
+      return;
+    }
+    if (!s_task)
+      xTaskCreatePinnedToCore(samplerTaskEntry, "motor_telemetry", 3072, nullptr, PRIO_SAMPLER, &s_task, CORE_APP);
+  }
+
+  bool arm(uint8_t triggerMask)
+  {
+    if (!s_task || !triggerMask)
+      return false;
+    // Leave Done first so no new download starts, then check for running ones: a download counts
+    // itself before it checks the state, so one of the two sides always backs off
+    const State prev = s_state.exchange(State::Idle);
+    if (s_downloads.load() > 0)
+    {
+      s_state.store(prev); // only Done has downloads; the sampler sleeps then
+      return false;
+    }
+    s_armMask.store(triggerMask);
+    xTaskNotifyGive(s_task);
+    Serial.printf("MotorTelemetry: armed (triggers 0x%02x)\n", triggerMask);
+    return true;
+  }
+
+  bool disarm()
+  {
+    const State prev = s_state.exchange(State::Idle);
+    if (s_downloads.load() > 0)
+    {
+      s_state.store(prev);
+      return false;
+    }
+    return true;
+  }
+
+  void trigger(Trigger reason) { s_pending.fetch_or(reason); }
+
+  State state() { return s_state.load(); }
+
+  uint16_t count() { return s_count; }
+
+  void attachRoutes(AsyncWebServer &server)
+  {
+    server.on("/telemetry/api/status", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      AsyncResponseStream *res = req->beginResponseStream("application/json");
+      res->printf("{\"state\":\"%s\",\"count\":%u,\"capacity\":%u,\"preTrigger\":%u,\"sampleHz\":%u,\"trigger\":%u}",
+                  stateName(state()), (unsigned)count(), (unsigned)CAPACITY, (unsigned)PRE_TRIGGER,
+                  (unsigned)SAMPLE_HZ, (unsigned)s_header.triggerReason);
+      req->send(res); });
+
+    server.on("/telemetry/api/arm", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      uint8_t mask = TRIG_START | TRIG_FAULT | TRIG_MANUAL;
+      if (req->hasParam("trig"))
+      {
+        const String t = req->getParam("trig")->value();
+        mask = (t.indexOf("start") >= 0 ? TRIG_START : 0) | (t.indexOf("fault") >= 0 ? TRIG_FAULT : 0) |
+               (t.indexOf("manual") >= 0 ? TRIG_MANUAL : 0);
+      }
+      if (!mask) { req->send(400, "text/plain", "trig=start,fault,manual"); return; }
+      if (!arm(mask)) { req->send(409, "text/plain", "download in progress"); return; }
+      req->send(200, "application/json", "{\"ok\":true}"); });
+
+    server.on("/telemetry/api/trigger", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      trigger(TRIG_MANUAL);
+      req->send(200, "application/json", "{\"ok\":true}"); });
+
+    server.on("/telemetry/api/disarm", HTTP_POST, [](AsyncWebServerRequest *req)
+              {
+      if (!disarm()) { req->send(409, "text/plain", "download in progress"); return; }
+      req->send(200, "application/json", "{\"ok\":true}"); });
+
+    server.on("/telemetry/api/data.csv", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      if (!beginDownload(req)) { req->send(409, "text/plain", "no capture"); return; }
+      const size_t len = CSV_HEADER_LEN + size_t(s_header.count) * CSV_ROW_LEN;
+      req->send(req->beginResponse("text/csv", len, fillCsv)); });
+
+    server.on("/telemetry/api/data.bin", HTTP_GET, [](AsyncWebServerRequest *req)
+              {
+      if (!beginDownload(req)) { req->send(409, "text/plain", "no capture"); return; }
+      const size_t len = sizeof(TelemetryHeader) + size_t(s_header.count) * sizeof(TelemetryRecord);
+      req->send(req->beginResponse("application/octet-stream", len, fillBin)); });
+  }
+
+} // namespace MotorTelemetry
@@ -0,0 +1,74 @@
+// MotorTelemetry: on-device capture of both motors' duty, direction/state and current at
+// SAMPLE_HZ into a RAM ring buffer, with pre-trigger history. Arm it, then a trigger (motor start,
+// driver fault or manual) freezes CAPACITY samples around the event for download as CSV or
+// binary from the web server. The sampler task only runs while armed.
+
+#pragma once
+
+#include <stdint.h>
+
+class DRV8874;
+class AsyncWebServer;
+
+struct __attribute__((packed)) TelemetryRecord
+{
+  uint32_t tUs;      // micros() at the sample
+  int16_t duty[2];   // applied duty × direction (-MAX_DUTY..MAX_DUTY), motor 1/2
+  uint16_t mA[2];    // CS current
+  uint8_t state[2];  // MotorState
+  uint8_t flags;     // bit0: trigger sample
+  uint8_t reserved;
+};
+static_assert(sizeof(TelemetryRecord) == 16, "TelemetryRecord must be 16 bytes");
+
+// Binary download: this header followed by count records, oldest first
+struct __attribute__((packed)) TelemetryHeader
+{
+  char magic[4] = {'M', 'T', 'E', 'L'};
+  uint8_t version = 1;
+  uint8_t triggerReason = 0; // MotorTelemetry::Trigger bit
+  uint16_t sampleHz = 0;
+  uint16_t count = 0;
+  uint16_t triggerIndex = 0; // record index of the trigger sample
+};
+
+namespace MotorTelemetry
+{
+  constexpr uint16_t CAPACITY = 2048;     // 32 KB, ~4 s at SAMPLE_HZ
+  constexpr uint16_t PRE_TRIGGER = 256;   // samples kept from before the trigger
+  constexpr uint16_t SAMPLE_HZ = 500;
+
+  enum Trigger : uint8_t
+  {
+    TRIG_START = 0x01,  // a motor starts from standstill
+    TRIG_FAULT = 0x02,  // driver fault (reported by trigger())
+    TRIG_MANUAL = 0x04, // trigger() from the web API or code
+  };
+
+  enum class State : uint8_t
+  {
+    Idle,      // not recording
+    Armed,     // recording pre-trigger history, waiting for a trigger
+    Capturing, // triggered, recording the post-trigger part
+    Done,      // frozen, downloadable
+  };
+
+  // Allocate the buffer and start the (sleeping) sampler task
+  void begin(const DRV8874 *motor1, const DRV8874 *motor2);
+
+  // Start recording; a trigger in triggerMask freezes the capture. Discards a previous capture.
+  // Both refuse (false) while a download of the capture is still streaming.
+  bool arm(uint8_t triggerMask = TRIG_START | TRIG_FAULT | TRIG_MANUAL);
+  bool disarm();
+
+  // Report an event (any task). Ignored unless armed for that reason.
+  void trigger(Trigger reason);
+
+  State state();
+  uint16_t count();
+
+  // GET  /telemetry/api/status, /telemetry/api/data.csv, /telemetry/api/data.bin
+  // POST /telemetry/api/arm?trig=start,fault,manual, /telemetry/api/trigger, /telemetry/api/disarm
+  void attachRoutes(AsyncWebServer &server);
+
+} // namespace MotorTelemetry
@@ -0,0 +1,36 @@
+// Closed-loop approach to a target position (ripple counts): full speed far away, linear
+// deceleration inside slowdownCounts, stop within toleranceCounts. The DRV8874 motion profile
+// smooths the speed steps.
+
+#pragma once
+#include <stdint.h>
+
+struct ApproachConfig
+{
+  uint8_t fastPt = 70;           // speed % far from the target
+  uint8_t slowPt = 10;           // speed % for the last counts
+  int32_t slowdownCounts = 400;  // start decelerating this far from the target
+  int32_t toleranceCounts = 4;   // settled when |target - position| <= tolerance
+};
+
+namespace Approach
+{
+  inline int32_t distance(int32_t position, int32_t target) { return target > position ? target - position : position - target; }
+
+  inline bool within(int32_t position, int32_t target, const ApproachConfig &cfg)
+  {
+    return distance(position, target) <= cfg.toleranceCounts;
+  }
+
+  // Signed speed % for DRV8874::run() toward target (+ = increasing position). 0 within tolerance.
+  inline int8_t speedPt(int32_t position, int32_t target, const ApproachConfig &cfg)
+  {
+    const int32_t dist = distance(position, target);
+    if (dist <= cfg.toleranceCounts)
+      return 0;
+    int32_t mag = cfg.fastPt;
+    if (dist < cfg.slowdownCounts && cfg.slowdownCounts > 0)
+      mag = cfg.slowPt + (int32_t(cfg.fastPt) - cfg.slowPt) * dist / cfg.slowdownCounts;
+    return int8_t(target > position ? mag : -mag);
+  }
+} // namespace Approach
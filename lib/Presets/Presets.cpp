@@ -0,0 +1,69 @@
+// Presets: implementation
+
+#include "Presets.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#include "DurstProtoTypes.h" // copy_cstr
+
+namespace
+{
+  // Default names: common paper sizes (cm)
+  const char *const DEFAULT_NAMES[Presets::MAX_PRESETS] = {"9x13", "10x15", "13x18", "18x24", "24x30", "30x40"};
+
+  Preferences s_prefs;
+  Preset s_presets[Presets::MAX_PRESETS];
+  uint8_t s_selected = 0;
+
+  void keyFor(uint8_t index, char (&key)[4])
+  {
+    snprintf(key, sizeof(key), "p%u", (unsigned)index);
+  }
+} // namespace
+
+namespace Presets
+{
+  void begin()
+  {
+    s_prefs.begin("presets", false);
+    for (uint8_t i = 0; i < MAX_PRESETS; ++i)
+    {
+      char key[4];
+      keyFor(i, key);
+      Preset p;
+      if (s_prefs.getBytesLength(key) == sizeof(Preset) && s_prefs.getBytes(key, &p, sizeof(Preset)) == sizeof(Preset))
+        s_presets[i] = p;
+      else
+        copy_cstr(s_presets[i].name, DEFAULT_NAMES[i]);
+      s_presets[i].name[sizeof(s_presets[i].name) - 1] = '\0';
+    }
+    s_selected = s_prefs.getUChar("sel", 0) % MAX_PRESETS;
+  }
+
+  uint8_t count() { return MAX_PRESETS; }
+
+  const Preset &get(uint8_t index) { return s_presets[index % MAX_PRESETS]; }
+
+  uint8_t selected() { return s_selected; }
+
+  uint8_t selectNext()
+  {
+    s_selected = (s_selected + 1) % MAX_PRESETS;
+    s_prefs.putUChar("sel", s_selected);
+    return s_selected;
+  }
+
+  void save(uint8_t index, int32_t m1Pos, int32_t m2Pos)
+  {
+    Preset &p = s_presets[index % MAX_PRESETS];
+    p.m1Pos = m1Pos;
+    p.m2Pos = m2Pos;
+    p.valid = true;
+    char key[4];
+    keyFor(index % MAX_PRESETS, key);
+    s_prefs.putBytes(key, &p, sizeof(Preset));
+    Serial.printf("Presets: saved %u '%s' m1=%ld m2=%ld\n", (unsigned)index, p.name, (long)m1Pos, (long)m2Pos);
+  }
+
+} // namespace Presets
@@ -0,0 +1,33 @@
+// Presets: named head/lens positions (e.g. per paper size) persisted in NVS.
+// Positions are DRV8874 ripple counts, only meaningful once the motors are homed.
+
+#pragma once
+
+#include <stdint.h>
+
+struct Preset
+{
+  char name[12] = "";
+  int32_t m1Pos = 0;
+  int32_t m2Pos = 0;
+  bool valid = false; // false until saved once
+};
+
+namespace Presets
+{
+  constexpr uint8_t MAX_PRESETS = 6;
+
+  // Load all presets and the last selection from NVS (Preferences namespace "presets")
+  void begin();
+
+  uint8_t count();
+  const Preset &get(uint8_t index);
+
+  // Current selection (persisted)
+  uint8_t selected();
+  uint8_t selectNext();
+
+  // Store positions into a slot, keeping its name
+  void save(uint8_t index, int32_t m1Pos, int32_t m2Pos);
+
+} // namespace Presets
@@ -2,10 +2,12 @@
 // Usage:
 //   SimpleRelay lamp(pin);
 //   lamp.on(); lamp.off(); lamp.toggle();
+//   lamp.onFromIsr(); lamp.offFromIsr(); // single register write, for timer ISRs
 
 #pragma once
 
 #include <Arduino.h>
+#include <soc/gpio_struct.h>
 
 class SimpleRelay
 {
@@ -47,7 +49,26 @@ public:
 
     bool isOn() const { return is_on_; }
 
+    // Direct GPIO set/clear register writes: always inlined, so safe to call from an IRAM ISR
+    __attribute__((always_inline)) inline void onFromIsr()
+    {
+        if (pin_ < 32)
+            GPIO.out_w1ts = (1u << pin_);
+        else
+            GPIO.out1_w1ts.val = (1u << (pin_ - 32));
+        is_on_ = true;
+    }
+
+    __attribute__((always_inline)) inline void offFromIsr()
+    {
+        if (pin_ < 32)
+            GPIO.out_w1tc = (1u << pin_);
+        else
+            GPIO.out1_w1tc.val = (1u << (pin_ - 32));
+        is_on_ = false;
+    }
+
 private:
     uint8_t pin_;
-    bool is_on_ = false;
+    volatile bool is_on_ = false; // also written by timer ISRs
 };
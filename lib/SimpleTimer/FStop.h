@@ -0,0 +1,44 @@
+// F-stop timer arithmetic: exposure times as base · 2^(twelfths / 12), so every step is the same
+// fraction of a stop regardless of the base time. 1/12, 1/6, 1/3 and 1 stop are 1, 2, 4 and 12
+// twelfths. Fixed-point table, no float pow in the loop.
+
+#pragma once
+#include <stdint.h>
+
+namespace FStop
+{
+  constexpr int8_t TWELFTHS_PER_STOP = 12;
+  constexpr int16_t MAX_OFFSET = 9 * TWELFTHS_PER_STOP; // ±9 stops (display has one digit)
+
+  // 2^(k/12) in Q16, k = 0..11
+  constexpr uint32_t POW2_TWELFTHS_Q16[TWELFTHS_PER_STOP] = {
+      65536, 69433, 73562, 77936, 82570, 87480, 92682, 98193, 104032, 110218, 116772, 123715};
+
+  // baseMs · 2^(twelfths / 12), rounded to ms
+  inline uint32_t scaleMs(uint32_t baseMs, int16_t twelfths)
+  {
+    int16_t stops = twelfths / TWELFTHS_PER_STOP;
+    int16_t frac = twelfths % TWELFTHS_PER_STOP;
+    if (frac < 0) // floor division: -1/12 = -1 stop + 11/12
+    {
+      frac += TWELFTHS_PER_STOP;
+      stops--;
+    }
+    uint64_t q16 = uint64_t(baseMs) * POW2_TWELFTHS_Q16[frac];
+    if (stops >= 0)
+      q16 <<= (stops > 20 ? 20 : stops);
+    else
+      q16 >>= (-stops > 40 ? 40 : -stops);
+    const uint64_t ms = (q16 + 0x8000u) >> 16;
+    return ms > UINT32_MAX ? UINT32_MAX : uint32_t(ms);
+  }
+
+  // Offset for display: sign, whole stops and hundredths of a stop (e.g. -16 → '-', 1, 33)
+  inline void split(int16_t twelfths, char &sign, uint8_t &stops, uint8_t &hundredths)
+  {
+    sign = twelfths < 0 ? '-' : '+';
+    const uint16_t mag = uint16_t(twelfths < 0 ? -twelfths : twelfths);
+    stops = uint8_t(mag / TWELFTHS_PER_STOP);
+    hundredths = uint8_t(((mag % TWELFTHS_PER_STOP) * 100u + TWELFTHS_PER_STOP / 2) / TWELFTHS_PER_STOP);
+  }
+} // namespace FStop
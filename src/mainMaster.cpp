@@ -8,25 +8,39 @@
 #include <rgb_lcd.h>
 
 #include "SimpleTimer.h"
+#include "FStop.h"
+#include "TestStrip.h"
+#include "ExposureProgram.h"
 #include "WifiPortal.h"
 #include "TM1638plusWrapper.h"
 #include "DisplayMux.h"
+#include "DurstProto.h"
 #include "DRV8874.h"
 #include "Buzzer.h"
 #include "Controls.h"
 #include "SimpleRelay.h"
+#include "Presets.h"
+#include "Approach.h"
+#include "FocusTrack.h"
+#include "MotorTelemetry.h"
+#include "BlackBox.h"
+#include "FaultManager.h"
+#include "LampTimer.h"
+#include "LightMeter.h"
+#include "ExposureLog.h"
 
 Preferences prefs;
 
-SimpleTimer timer(9000);
+SimpleTimer timer(9000); // UI clock (countdown display); LampTimer cuts the lamp
 
 // Lamp SSR relay (declare before onTimerDone)
 constexpr uint8_t LAMP_RELAY_PIN = 33;
 SimpleRelay lamp(LAMP_RELAY_PIN);
+constexpr uint8_t LAMP_ZC_PIN = 0; // zero-cross detector output (e.g. 39), 0 = not fitted
+constexpr uint8_t LIGHT_METER_PIN = 0; // photodiode amplifier output, ADC1 (e.g. 36), 0 = not fitted
 
 static void onTimerDone(void *ctx)
 {
-  lamp.off();
   Serial.println("Timer finished!");
 }
 
@@ -52,6 +66,15 @@ constexpr uint8_t LEDC_CH = 4;     // LEDC channel you want to use
 constexpr int8_t LED_PIN = -1;     // optional LED; or -1 to disable
 
 Buzzer buzz(BUZZER_PIN, LEDC_CH, LED_PIN);
+constexpr bool EXPOSURE_METRONOME = true; // tick every second of an exposure, last 3 accented
+// Double beep: move the card / dodge / burn now
+constexpr Buzzer::Step CUE_PATTERN[] = {{120, 1500, 255}, {80, 0, 0}, {120, 1500, 255}};
+
+void startMetronome(uint32_t durationMs, uint8_t countdownTicks = 3)
+{
+  if (EXPOSURE_METRONOME)
+    buzz.startMetronome(durationMs, 1000, countdownTicks);
+}
 
 // ================= TWO motors =================
 
@@ -67,7 +90,7 @@ constexpr uint8_t M1_CH2 = 1;
 constexpr uint8_t M2_IN1 = 18;
 constexpr uint8_t M2_IN2 = 19;
 constexpr uint8_t M2_SLEEP = 0; // if hard-wired HIGH, set to 0
-constexpr uint8_t M2_FAULT = 27;
+constexpr uint8_t M2_FAULT = 27; // open-drain, wired-OR with M1_FAULT: a fault cuts both motors
 constexpr uint8_t M2_CS = 34;
 constexpr uint8_t M2_CH1 = 2;
 constexpr uint8_t M2_CH2 = 3;
@@ -80,15 +103,171 @@ DRV8874 motor1(M1_IN1, M1_IN2, M1_CS, M1_SLEEP, M1_CH1, M1_CH2,
 DRV8874 motor2(M2_IN1, M2_IN2, M2_CS, M2_SLEEP, M2_CH1, M2_CH2,
                584 /* minDutyPos */, 579 /* minDutyNeg */);
 
+// unsigned motorspeed in % of MAX_DUTY
+constexpr uint8_t SLOW_PT = 10;
+constexpr uint8_t FAST_PT = 70;
+constexpr uint8_t INSANE_PT = 100;
+
+// Speed ramps for run(): S-curve, 0→100% in ~0.4 s. Softens reversals and SLOW→INSANE jumps
+constexpr MotionLimits MOTOR_MOTION_LIMITS{300 /* accelPctPerS */, 3000 /* jerkPctPerS2 */};
+
+// End stops / limit switches: the DRV8874 current limit (VREF) is just under 2 A, so a stalled
+// motor sits close to it. Running current stays well below in both directions.
+constexpr StallDetectConfig MOTOR_STALL_DETECT{1500 /* thresholdPosmA */, 1500 /* thresholdNegmA */, 6 /* holdMs */};
+
+// Coupled focus: lens (M2) follows the head (M1) through the FocusTrack table
+bool focusCoupled = false;   // mode, toggled by the user (persisted)
+bool focusFollowing = false; // lens currently driven by the tracker
+
+// F-stop timer mode: duration = base · 2^(offset / 12), adjusted in 1/12, 1/6, 1/3 or 1 stop steps
+bool fStopMode = false;     // persisted
+uint32_t fStopBaseMs = 0;   // duration when the mode was entered (persisted)
+int16_t fStopOffset = 0;    // twelfths of a stop (persisted at timer start)
+constexpr uint32_t TIMER_MIN_MS = 100;
+constexpr uint32_t TIMER_MAX_MS = 9999000;
+
+// Exposure modes, cycled with L3 (persisted). Start timer runs the current mode.
+enum class ExposureMode : uint8_t
+{
+  Single,    // one exposure of the timer duration
+  TestStrip, // incremental strips from the timer duration, card moved between steps
+  Program,   // multi-segment dodge/burn program (ExposureProgram, edited from the web UI)
+  Metered,   // light meter integrates the dose of the timer time at the reference level
+  Count,
+};
+const char *const EXPOSURE_MODE_NAMES[] = {"Single exposure", "Test strip", "Program", "Light meter"};
+ExposureMode exposureMode = ExposureMode::Single;
+
+// Test strip: TEST_STRIP_STEPS strips from the timer duration, spaced by that duration (linear)
+// or TEST_STRIP_FSTOP_TWELFTHS (f-stop mode). Each step is one LampTimer exposure; the next
+// one starts on Start timer after the card was moved.
+constexpr uint8_t TEST_STRIP_STEPS = 6;
+constexpr int16_t TEST_STRIP_FSTOP_TWELFTHS = 4; // 1/3 stop
+
+struct TestStripRun
+{
+  bool active = false;
+  bool exposing = false; // a step's lamp exposure is running
+  uint8_t next = 0;      // step to expose next
+  uint8_t count = 0;
+  uint32_t stepMs[TestStrip::MAX_STEPS] = {};
+  uint32_t timerMs = 0; // timer duration before the run, restored after it
+};
+TestStripRun strip;
+
+uint32_t programTimerMs = 0; // timer duration before a program run, restored after it
+
+// Metered exposure: the meter cuts the lamp at the dose; the timer runs the safety maximum
+constexpr uint16_t METER_MAX_PERCENT = 200; // of the timer time
+bool metering = false;
+uint32_t meterTimerMs = 0; // timer duration before the exposure, restored after it
+
+// Short status messages on LCD line 1 (instead of the positions) for LCD_MESSAGE_MS
+constexpr uint32_t LCD_MESSAGE_MS = 2000;
+char lcdMessage[17] = "";
+uint32_t lcdMessageUntilMs = 0;
+
+void showMessage(const char *msg)
+{
+  snprintf(lcdMessage, sizeof(lcdMessage), "%-16s", msg);
+  lcdMessageUntilMs = millis() + LCD_MESSAGE_MS;
+  Serial.printf("mainMaster: %s\n", msg);
+}
+
+// NVS writes wait for the end of an exposure (LampTimer::beginFlashWrite): settings changed in
+// loop are marked dirty here and written by flushPrefs() once the lamp is off
+enum PrefKey : uint8_t
+{
+  PREF_DURATION = 0x01,
+  PREF_FSTOP_OFFSET = 0x02,
+  PREF_FSTOP = 0x04, // mode and base
+  PREF_FOCUS_TRACK = 0x08,
+  PREF_BRIGHTNESS = 0x10,
+  PREF_EXPOSURE_MODE = 0x20,
+};
+uint8_t prefsDirty = 0;
+uint32_t prefsDurationMs = 0; // last used duration (not the metered maximum the timer shows)
+
+void flushPrefs()
+{
+  if (!prefsDirty || !LampTimer::beginFlashWrite())
+    return;
+  if (prefsDirty & PREF_DURATION)
+    prefs.putULong("duration", prefsDurationMs); // save last used duration for next boot
+  if (prefsDirty & PREF_FSTOP_OFFSET)
+    prefs.putShort("fOff", fStopOffset);
+  if (prefsDirty & PREF_FSTOP)
+  {
+    prefs.putBool("fstop", fStopMode);
+    prefs.putULong("fBase", fStopBaseMs);
+  }
+  if (prefsDirty & PREF_FOCUS_TRACK)
+    prefs.putBool("focusTrk", focusCoupled);
+  if (prefsDirty & PREF_BRIGHTNESS)
+    prefs.putUChar("brightness", brightness);
+  if (prefsDirty & PREF_EXPOSURE_MODE)
+    prefs.putUChar("expMode", uint8_t(exposureMode));
+  LampTimer::endFlashWrite();
+  prefsDirty = 0;
+}
+
+// Controls that store something right away (presets, focus points) are refused during an
+// exposure. On true the caller writes, then calls LampTimer::endFlashWrite().
+bool lockFlashOrRefuse()
+{
+  if (LampTimer::beginFlashWrite())
+    return true;
+  showMessage("Wait: exposing");
+  buzz.buzz(150, 255, 400);
+  return false;
+}
+
+// Motor positions to slaves: on change at most every MOTOR_STATUS_MIN_MS, unchanged every MOTOR_STATUS_RESEND_MS
+constexpr uint32_t MOTOR_STATUS_MIN_MS = 100;
+constexpr uint32_t MOTOR_STATUS_RESEND_MS = 1000;
+
+void broadcastMotorStatus(const MotorStatus &s1, const MotorStatus &s2)
+{
+  static MsgMotorStatusV1 last{};
+  static uint32_t lastMs = 0;
+  const uint32_t now = millis();
+
+  MsgMotorStatusV1 msg{};
+  msg.flags = (s1.homed ? 0x01 : 0) | (s2.homed ? 0x02 : 0);
+  msg.position[0] = s1.position;
+  msg.position[1] = s2.position;
+  msg.dir[0] = s1.dir;
+  msg.dir[1] = s2.dir;
+
+  const bool changed = msg.flags != last.flags || msg.position[0] != last.position[0] ||
+                       msg.position[1] != last.position[1] || msg.dir[0] != last.dir[0] || msg.dir[1] != last.dir[1];
+  if (now - lastMs < (changed ? MOTOR_STATUS_MIN_MS : MOTOR_STATUS_RESEND_MS))
+    return;
+
+  msg.seq = last.seq + 1;
+  DurstProto::broadcastMotorStatus(msg);
+  last = msg;
+  lastMs = now;
+}
+
 void updateDisplay(const uint8_t brightness, const bool lampState, const DRV8874 &m1, const DRV8874 &m2, const SimpleTimer &timer,
                    const bool anyDirectionConflict, const bool m1Fault, const bool m2Fault)
 {
   char segText[11] = "";                  // 2x4 chars + optional 2 x 1 decimal point + NUL for TM1638plus::displayText
-  char lcdLine1[17] = "I'm the master!!"; // 16 chars + NUL. Slave ignores lcdLine1 and overrides with debug info
+  char lcdLine1[17] = ""; // 16 chars + NUL. Slave ignores lcdLine1 and overrides with debug info
   char lcdLine2[17] = "";
 
-  const int32_t m1Signed = m1.getDutyCmd() * m1.getDirection();
-  const int32_t m2Signed = m2.getDutyCmd() * m2.getDirection();
+  const MotorStatus s1 = m1.getStatus(); // one consistent snapshot per motor
+  const MotorStatus s2 = m2.getStatus();
+  const int32_t m1Signed = s1.dutyCmd * s1.dir;
+  const int32_t m2Signed = s2.dutyCmd * s2.dir;
+
+  // Positions in ripple counts; '?' until re-zeroed at an end stop
+  if ((int32_t)(millis() - lcdMessageUntilMs) < 0)
+    copy_cstr(lcdLine1, lcdMessage);
+  else
+    snprintf(lcdLine1, sizeof(lcdLine1), "%+6ld%c%c %+6ld%c", (long)s1.position, s1.homed ? ' ' : '?',
+             focusCoupled ? 'F' : ' ', (long)s2.position, s2.homed ? ' ' : '?');
   const uint32_t timerMs = static_cast<uint32_t>(timer.remainingMs());
   uint16_t tenths = (timerMs + 50) / 100; // round to 0.1s
   uint16_t whole = tenths / 10;
@@ -100,34 +279,373 @@ void updateDisplay(const uint8_t brightness, const bool lampState, const DRV8874
 
   int8_t errorCode = m1Fault ? 1 : m2Fault            ? 2
                                : anyDirectionConflict ? 3
+                               : s1.stallDir != 0     ? 4
+                               : s2.stallDir != 0     ? 5
                                                       : 0;
 
   int firstSeg = errorCode ? errorCode : (int)toDisplayClamped;
   const char lampStateChar = lampState ? 'L' : ' ';
 
-  snprintf(segText, sizeof(segText),
-           errorCode ? "ERR%1d%3u.%u" : "%4d%1c%2u.%u",
-           firstSeg, lampStateChar, (unsigned)whole, (unsigned)frac);
+  if (fStopMode && !errorCode && toDisplay == 0)
+  {
+    // Offset from the base time in stops instead of the (idle) duty: TM "F1.33" / "-0.67", LCD "f+1.33"
+    char sign;
+    uint8_t stops, hundredths;
+    FStop::split(fStopOffset, sign, stops, hundredths);
+    snprintf(segText, sizeof(segText), "%c%1u.%02u%1c%2u.%u", sign == '-' ? '-' : 'F', stops, hundredths,
+             lampStateChar, (unsigned)whole, (unsigned)frac);
+    snprintf(lcdLine2, sizeof(lcdLine2), "f%c%1u.%02u   %1c%3u.%us", sign, stops, hundredths, lampStateChar,
+             (unsigned int)whole, frac);
+  }
+  else
+  {
+    snprintf(segText, sizeof(segText),
+             errorCode ? "ERR%1d%3u.%u" : "%4d%1c%2u.%u",
+             firstSeg, lampStateChar, (unsigned)whole, (unsigned)frac);
 
-  snprintf(lcdLine2, sizeof(lcdLine2),
-           errorCode ? "ERROR:%1d  %4u.%us" : "%5d    %1c%3u.%us",
-           errorCode ? errorCode : (int)toDisplay, lampStateChar, (unsigned int)whole, frac);
+    snprintf(lcdLine2, sizeof(lcdLine2),
+             errorCode ? "ERROR:%1d  %4u.%us" : "%5d    %1c%3u.%us",
+             errorCode ? errorCode : (int)toDisplay, lampStateChar, (unsigned int)whole, frac);
+  }
 
   displays.displayAndBroadCastTexts(brightness, segText, lcdLine1, lcdLine2);
+  broadcastMotorStatus(s1, s2);
 }
 
 // Controls handled by Controls module
 
-volatile bool faultM1 = false;
-void IRAM_ATTR onM1Fault() { faultM1 = true; }
-volatile bool faultM2 = false;
-void IRAM_ATTR onM2Fault() { faultM2 = true; }
+// ================= Test strip =================
+// The timer shows each step's countdown; its own duration comes back when the run ends
+
+void startStripStep()
+{
+  char msg[17];
+  snprintf(msg, sizeof(msg), "Strip %u/%u", strip.next + 1, strip.count);
+  showMessage(msg);
+  timer.setDurationMs(strip.stepMs[strip.next]);
+  timer.start(onTimerDone);
+  startMetronome(timer.getDurationMs());
+  strip.exposing = LampTimer::start(strip.stepMs[strip.next]);
+}
+
+bool startStrip()
+{
+  TestStripConfig cfg;
+  cfg.steps = TEST_STRIP_STEPS;
+  cfg.fStop = fStopMode;
+  cfg.baseMs = timer.getDurationMs();
+  cfg.incrementMs = cfg.baseMs;
+  cfg.incrementTwelfths = TEST_STRIP_FSTOP_TWELFTHS;
+  strip.count = TestStrip::build(cfg, strip.stepMs);
+  if (strip.count == 0)
+    return false;
+  strip.active = true;
+  strip.exposing = false;
+  strip.next = 0;
+  strip.timerMs = cfg.baseMs;
+  Serial.printf("mainMaster: test strip %u steps, %s spacing from %lu ms\n", strip.count, cfg.fStop ? "f-stop" : "linear",
+                (unsigned long)cfg.baseMs);
+  return true;
+}
+
+void endStrip(bool aborted)
+{
+  timer.stop();
+  buzz.stopMetronome();
+  timer.setDurationMs(strip.timerMs);
+  strip.active = strip.exposing = false;
+  showMessage(aborted ? "Strip aborted" : "Strip done");
+  buzz.buzz(aborted ? 150 : 60, 255, aborted ? 400 : 2000);
+}
+
+// Called with every finished LampTimer exposure
+void onStripExposureDone(const LampTimer::Exposure &ex)
+{
+  if (!strip.active || !strip.exposing || ex.cancelled)
+    return;
+  strip.exposing = false;
+  if (++strip.next >= strip.count)
+  {
+    endStrip(false);
+    return;
+  }
+  char msg[17];
+  snprintf(msg, sizeof(msg), "Move card %u/%u", strip.next + 1, strip.count);
+  showMessage(msg);
+  buzz.play(CUE_PATTERN, Buzzer::PRIO_CUE); // cover the next strip, then Start timer
+}
+
+// ================= Exposure program =================
+// ExposureProgram times the segments and the lamp; the timer only shows each group's countdown
+
+void startProgramGroup()
+{
+  const bool first = ExposureProgram::state() == ExposureProgram::State::Idle;
+  if (!ExposureProgram::start())
+  {
+    buzz.buzz(300, 255, 400);
+    return;
+  }
+  if (first)
+    programTimerMs = timer.getDurationMs();
+  timer.setDurationMs(ExposureProgram::groupMs());
+  timer.start(onTimerDone);
+  startMetronome(timer.getDurationMs());
+  Serial.printf("mainMaster: program group from segment %u, %lu ms\n", ExposureProgram::segmentIndex() + 1,
+                (unsigned long)ExposureProgram::groupMs());
+}
+
+void endProgram(bool aborted)
+{
+  if (aborted)
+    ExposureProgram::cancel();
+  timer.stop();
+  buzz.stopMetronome();
+  timer.setDurationMs(programTimerMs);
+  showMessage(aborted ? "Program aborted" : "Program done");
+  buzz.buzz(aborted ? 150 : 60, 255, aborted ? 400 : 2000);
+}
+
+// Cue beeps, wait prompts and the end of the program. Call every loop.
+void serviceProgram()
+{
+  ExposureProgram::service();
+  static ExposureProgram::State prev = ExposureProgram::State::Idle;
+  const ExposureProgram::State state = ExposureProgram::state();
+  if (ExposureProgram::takeCue())
+    buzz.play(CUE_PATTERN, Buzzer::PRIO_CUE); // dodge/burn
+  if (state == ExposureProgram::State::Waiting && prev != state)
+  {
+    char msg[17];
+    snprintf(msg, sizeof(msg), "Seg %u: Start", ExposureProgram::segmentIndex() + 1);
+    showMessage(msg);
+    buzz.play(CUE_PATTERN, Buzzer::PRIO_CUE);
+  }
+  if (ExposureProgram::takeFinished())
+    endProgram(false);
+  prev = state;
+}
+
+// ================= Metered exposure =================
+
+void startMetered()
+{
+  if (!LightMeter::isCalibrated())
+  {
+    showMessage(LightMeter::isAttached() ? "Meter not calib." : "No light meter");
+    buzz.buzz(300, 255, 400);
+    return;
+  }
+  meterTimerMs = timer.getDurationMs();
+  prefsDurationMs = meterTimerMs;
+  prefsDirty |= PREF_DURATION | (fStopMode ? PREF_FSTOP_OFFSET : 0);
+  const uint32_t maxMs = uint32_t(uint64_t(meterTimerMs) * METER_MAX_PERCENT / 100);
+  LightMeter::start(meterTimerMs);
+  timer.setDurationMs(maxMs);
+  timer.start(onTimerDone);
+  startMetronome(maxMs, 0); // the meter ends it: no countdown to the maximum
+  metering = LampTimer::start(maxMs); // lamp on now, off by the meter or at the maximum
+  if (!metering)
+    LightMeter::stop();
+  Serial.printf("mainMaster: metered exposure %lu ms at %u%% of the reference, max %lu ms\n",
+                (unsigned long)meterTimerMs, LightMeter::relativePct(), (unsigned long)maxMs);
+}
+
+// Called with every finished LampTimer exposure
+void onMeteredExposureDone(const LampTimer::Exposure &ex)
+{
+  if (!metering)
+    return;
+  metering = false;
+  LightMeter::stop();
+  timer.stop();
+  buzz.stopMetronome();
+  timer.setDurationMs(meterTimerMs);
+  const LightMeter::Dose d = LightMeter::dose();
+  Serial.printf("mainMaster: metered exposure %s: dose %llu/%llu ref us in %llu us of lamp\n",
+                d.reached ? "done" : ex.cancelled ? "cancelled" : "hit the maximum", (unsigned long long)d.doseUs,
+                (unsigned long long)d.targetUs, (unsigned long long)ex.pinUs);
+  if (ex.cancelled)
+    return;
+  char msg[17];
+  if (d.reached)
+    snprintf(msg, sizeof(msg), "Lamp %lu.%lus", (unsigned long)(ex.pinUs / 1000000), (unsigned long)(ex.pinUs / 100000 % 10));
+  else
+    snprintf(msg, sizeof(msg), "Max hit %lu%%", (unsigned long)(d.targetUs ? d.doseUs * 100 / d.targetUs : 0));
+  showMessage(msg);
+  if (!d.reached)
+    buzz.buzz(300, 255, 400); // underexposed: lamp far below the reference
+}
+
+// ================= Exposure log =================
+
+// Called with every finished LampTimer exposure, before the mode handlers move on
+void logExposure(const LampTimer::Exposure &ex, const MotorStatus &head, const MotorStatus &lens)
+{
+  ExposureLogRecord rec;
+  rec.uptimeMs = millis();
+  rec.mode = uint8_t(exposureMode);
+  if (strip.active)
+    rec.step = strip.next;
+  else if (exposureMode == ExposureMode::Program)
+    rec.step = ExposureProgram::segmentIndex();
+  rec.requestedMs = uint32_t(ex.requestedUs / 1000);
+  rec.lampMs = uint32_t(ex.pinUs / 1000);
+  rec.headPos = head.position;
+  rec.lensPos = lens.position;
+  rec.fStopOffset = fStopMode ? fStopOffset : 0;
+  rec.flags = (ex.cancelled ? ExposureLog::FLAG_CANCELLED : 0) | (fStopMode ? ExposureLog::FLAG_FSTOP : 0) |
+              (head.homed ? ExposureLog::FLAG_HEAD_HOMED : 0) | (lens.homed ? ExposureLog::FLAG_LENS_HOMED : 0) |
+              (metering && LightMeter::dose().reached ? ExposureLog::FLAG_METERED : 0);
+  ExposureLog::append(rec); // queued, written by the log task
+}
+
+// ================= Presets: go-to moves =================
+// Full FAST_PT far away, decelerate over the last counts, brake within tolerance
+constexpr ApproachConfig PRESET_APPROACH{FAST_PT /* fastPt */, SLOW_PT /* slowPt */,
+                                         400 /* slowdownCounts */, 4 /* toleranceCounts */};
+constexpr uint32_t PRESET_MOVE_TIMEOUT_MS = 30000;
+
+struct PresetMove
+{
+  bool active = false;
+  int32_t target = 0;
+  uint32_t startedMs = 0;
+  bool aborted = false;
+};
+PresetMove move1, move2;
+
+void startPresetMove()
+{
+  const uint8_t idx = Presets::selected();
+  const Preset &p = Presets::get(idx);
+  char msg[17];
+  if (!p.valid || !motor1.isHomed() || !motor2.isHomed())
+  {
+    showMessage(!p.valid ? "Preset empty" : "Home motors 1st");
+    buzz.buzz(150, 255, 400);
+    return;
+  }
+  const uint32_t now = millis();
+  move1 = PresetMove{true, p.m1Pos, now, false};
+  move2 = PresetMove{true, p.m2Pos, now, false};
+  snprintf(msg, sizeof(msg), "Go P%u %s", (unsigned)idx + 1, p.name);
+  showMessage(msg);
+}
+
+// One loop step of a go-to move for one motor. Returns true while the move owns the motor.
+// A manual press, a fault/conflict, a stall or the timeout aborts it (manual control takes over).
+bool stepPresetMove(DRV8874 &m, const MotorStatus &st, PresetMove &mv, int8_t manualDir, bool blocked)
+{
+  if (!mv.active)
+    return false;
+  if (manualDir != 0 || blocked || st.stallDir != 0 || millis() - mv.startedMs > PRESET_MOVE_TIMEOUT_MS)
+  {
+    mv.active = false;
+    mv.aborted = true;
+    return false;
+  }
+
+  const int8_t speedPt = Approach::speedPt(st.position, mv.target, PRESET_APPROACH);
+  if (speedPt == 0)
+  {
+    if (m.getSpeed() != 0)
+      m.brake();
+    else if (st.state == MotorState::Idle) // brake window over: settled (re-approaches if it drifted out)
+      mv.active = false;
+  }
+  else if (m.getSpeed() != speedPt)
+    m.run(speedPt);
+  return mv.active;
+}
+
+// ================= Coupled focus tracking =================
+// Lens follows at up to INSANE_PT to keep up with a FAST head; starts correcting only while the
+// head moves and the lens is off by more than FOCUS_START_COUNTS, then settles and releases.
+constexpr ApproachConfig FOCUS_APPROACH{INSANE_PT /* fastPt */, SLOW_PT /* slowPt */,
+                                        200 /* slowdownCounts */, 6 /* toleranceCounts */};
+constexpr int32_t FOCUS_START_COUNTS = 12;
+constexpr uint32_t FOCUS_CLEAR_HOLD_MS = 3000;
+
+// One loop step of the lens follower. Returns true while it owns motor2.
+// A manual lens press (fine focus), fault/conflict or stall releases the lens to manual control.
+bool stepFocusTrack(const MotorStatus &head, const MotorStatus &lens, int8_t manualLensDir, bool blocked)
+{
+  int32_t target = 0;
+  if (!focusCoupled || blocked || manualLensDir != 0 || lens.stallDir != 0 || !head.homed || !lens.homed ||
+      !FocusTrack::lensFor(head.position, target))
+  {
+    focusFollowing = false;
+    return false;
+  }
+
+  if (!focusFollowing)
+  {
+    if (head.dir == 0 || Approach::distance(lens.position, target) <= FOCUS_START_COUNTS)
+      return false;
+    focusFollowing = true;
+  }
+
+  const int8_t speedPt = Approach::speedPt(lens.position, target, FOCUS_APPROACH);
+  if (speedPt == 0)
+  {
+    if (motor2.getSpeed() != 0)
+      motor2.brake();
+    else if (head.dir == 0 && lens.state == MotorState::Idle) // head stopped and lens settled
+      focusFollowing = false;
+  }
+  else if (motor2.getSpeed() != speedPt)
+    motor2.run(speedPt);
+  return focusFollowing;
+}
 
 // ================= Web server & WifiPortal =================
 
 AsyncWebServer webServer(80);
 WifiPortal wifiPortal(MESH_SSID, MESH_PASS);
 
+// Web requests run in the AsyncTCP task; motor commands must come from loop() (single producer)
+volatile uint8_t calibrateRequest = 0; // 1/2: calibrate motor1/motor2 on the next loop
+
+static const char *motorStateName(MotorState st)
+{
+  switch (st)
+  {
+  case MotorState::Running:
+    return "running";
+  case MotorState::Braking:
+    return "braking";
+  case MotorState::Stalled:
+    return "stalled";
+  case MotorState::Calibrating:
+    return "calibrating";
+  default:
+    return "idle";
+  }
+}
+
+static void attachMotorRoutes()
+{
+  webServer.on("/motor/api/calibrate", HTTP_POST, [](AsyncWebServerRequest *req)
+               {
+    const int m = req->hasParam("m") ? req->getParam("m")->value().toInt() : 0;
+    if (m != 1 && m != 2) { req->send(400, "text/plain", "m=1|2 required"); return; }
+    calibrateRequest = uint8_t(m);
+    req->send(200, "application/json", "{\"ok\":true}"); });
+
+  webServer.on("/motor/api/calibrate", HTTP_GET, [](AsyncWebServerRequest *req)
+               {
+    AsyncResponseStream *res = req->beginResponseStream("application/json");
+    const DRV8874 *motors[2] = {&motor1, &motor2};
+    res->print('[');
+    for (uint8_t i = 0; i < 2; ++i)
+      res->printf("%s{\"m\":%u,\"state\":\"%s\",\"minDutyPos\":%lu,\"minDutyNeg\":%lu}", i ? "," : "",
+                  (unsigned)i + 1, motorStateName(motors[i]->getStatus().state),
+                  (unsigned long)motors[i]->getMinDutyPos(), (unsigned long)motors[i]->getMinDutyNeg());
+    res->print(']');
+    req->send(res); });
+}
+
 static void attachRoutes()
 {
   if (!(LittleFS.begin(false) || LittleFS.begin(true))) // idempotent
@@ -141,9 +659,21 @@ static void attachRoutes()
       .setFilter([](AsyncWebServerRequest *r)
                  {
                 const String& u = r->url();
-                return !(u.startsWith("/wifi/api/") || u == "/wifi/api"); });
+                return !(u.startsWith("/wifi/api/") || u == "/wifi/api" || u.startsWith("/motor/api/") ||
+                         u.startsWith("/telemetry/api/") || u.startsWith("/blackbox/api/") ||
+                         u.startsWith("/fault/api/") || u.startsWith("/lamp/api/") ||
+                         u.startsWith("/program/api/") || u.startsWith("/meter/api/") ||
+                         u.startsWith("/log/api/")); });
 
   ;
+  attachMotorRoutes();
+  MotorTelemetry::attachRoutes(webServer);
+  BlackBox::attachRoutes(webServer);
+  FaultManager::attachRoutes(webServer);
+  LampTimer::attachRoutes(webServer);
+  ExposureProgram::attachRoutes(webServer);
+  LightMeter::attachRoutes(webServer);
+  ExposureLog::attachRoutes(webServer);
 }
 
 // ================= Setup =================
@@ -151,11 +681,19 @@ void setup()
 {
   Serial.begin(115200);
 
+  BlackBox::begin(); // before anything can record: keeps a pre-reset capture frozen
+
   lamp.begin(); // default initial state: OFF
+  LampTimer::begin(&lamp);
+  if (LAMP_ZC_PIN)
+    LampTimer::setZeroCross(LAMP_ZC_PIN); // 50 Hz mains, see ZeroCrossConfig
+  ExposureProgram::begin();
 
   attachRoutes();
   wifiPortal.beginAndConnect(webServer, /*staTimeoutMs=*/10000);
   webServer.begin();
+  configTime(0, 0, "pool.ntp.org"); // UTC for the exposure log, synced in the background once STA is up
+  ExposureLog::begin();
 
   buzz.begin();
 
@@ -171,18 +709,29 @@ void setup()
 
   Serial.printf("Setup(): brightness=%d\n", brightness);
 
-  analogReadResolution(12);
-  // Set default attenuation for all ADC reads. Per-pin attenuation before
-  // first read can log errors on ESP32 Arduino v3.x, so avoid that here.
-  analogSetAttenuation(CS_ADC_ATTENUATION);
+  Presets::begin();
+  FocusTrack::begin();
+  focusCoupled = prefs.getBool("focusTrk", false);
+  fStopMode = prefs.getBool("fstop", false);
+  exposureMode = ExposureMode(prefs.getUChar("expMode", 0) % uint8_t(ExposureMode::Count));
+  fStopBaseMs = prefs.getULong("fBase", timer.getDurationMs());
+  fStopOffset = prefs.getShort("fOff", 0);
+
+  motor1.setMotionLimits(MOTOR_MOTION_LIMITS);
+  motor1.setStallDetection(MOTOR_STALL_DETECT);
+  motor1.begin("m1"); // calibrated min duties (POST /motor/api/calibrate) override the values above
+  FaultManager::attach(M1_FAULT, &motor1); // nFAULT ISR cuts the outputs directly
+
+  motor2.setMotionLimits(MOTOR_MOTION_LIMITS);
+  motor2.setStallDetection(MOTOR_STALL_DETECT);
+  motor2.begin("m2");
+  FaultManager::attach(M2_FAULT, &motor2);
 
-  motor1.begin();
-  pinMode(M1_FAULT, INPUT_PULLUP); // or INPUT with external 10k
-  attachInterrupt(digitalPinToInterrupt(M1_FAULT), onM1Fault, FALLING);
+  if (LIGHT_METER_PIN)
+    LightMeter::begin(LIGHT_METER_PIN); // after the motors: joins their current-sense sampler
 
-  motor2.begin();
-  pinMode(M2_FAULT, INPUT_PULLUP); // or INPUT with external 10k
-  attachInterrupt(digitalPinToInterrupt(M2_FAULT), onM2Fault, FALLING);
+  // Telemetry capture of both motors (arm / download via /telemetry/api/...)
+  MotorTelemetry::begin(&motor1, &motor2);
 
   // ---- Controls (TM1638 + controller using BluePad32) ----
   Controls::begin(&tm);
@@ -192,43 +741,175 @@ void setup()
 
 void loop()
 {
-  // unsigned motorspeed in % of MAX_DUTY
-  constexpr uint8_t SLOW_PT = 10;
-  constexpr uint8_t FAST_PT = 70;
-  constexpr uint8_t INSANE_PT = 100;
-
   // Update controls (merges TM1638 + BT) and fetch state
   Controls::update();
   const auto &cs = Controls::state();
-  if (motor1.getDutyCmd() > 0 || motor2.getDutyCmd())
-    Serial.printf(">m1DutyCmd:%d,m2DutyCmd:%d,m1A:%.2f,m2A:%.2f,\r\n",
-                  motor1.getDutyCmd(), motor2.getDutyCmd(), motor1.getCurrentmA() / 1000.0f, motor2.getCurrentmA() / 1000.0f);
+  const MotorStatus m1Status = motor1.getStatus();
+  const MotorStatus m2Status = motor2.getStatus();
 
   uint8_t speedControlPt = cs.Fast ? FAST_PT : cs.Insane ? INSANE_PT
                                                          : SLOW_PT;
 
-  // TODO: race conditions? also, do we need debounce?
-  bool debouncedFaultM1 = false;
-  bool debouncedFaultM2 = false;
-  if (faultM1)
+  // Driver faults: the ISR already cut the outputs; latched until recovery (StartTimer or web)
+  const uint8_t newFaults = FaultManager::service();
+  const bool faultM1 = FaultManager::isLatched(0);
+  const bool faultM2 = FaultManager::isLatched(1);
+
+  // Black box: one record per loop (RTC memory), frozen on the first fault
+  BlackBoxRecord bb;
+  bb.ms = millis();
+  bb.duty[0] = int16_t(int32_t(m1Status.dutyCmd) * m1Status.dir);
+  bb.duty[1] = int16_t(int32_t(m2Status.dutyCmd) * m2Status.dir);
+  bb.mA[0] = uint16_t(motor1.getCurrentmA());
+  bb.mA[1] = uint16_t(motor2.getCurrentmA());
+  bb.buttons = cs.buttonsMask;
+  bb.flags = (lamp.isOn() ? BlackBox::FLAG_LAMP : 0) | (timer.isRunning() ? BlackBox::FLAG_TIMER : 0) |
+             (faultM1 ? BlackBox::FLAG_FAULT1 : 0) | (faultM2 ? BlackBox::FLAG_FAULT2 : 0) |
+             (m1Status.stallDir ? BlackBox::FLAG_STALL1 : 0) | (m2Status.stallDir ? BlackBox::FLAG_STALL2 : 0) |
+             (cs.anyDirectionConflict ? BlackBox::FLAG_CONFLICT : 0);
+  const int64_t remainingDs = timer.remainingMs() / 100;
+  bb.timerDs = uint16_t(remainingDs <= 0 ? 0 : (remainingDs > UINT16_MAX ? UINT16_MAX : remainingDs));
+  BlackBox::record(bb);
+
+  if (newFaults)
+  {
+    MotorTelemetry::trigger(MotorTelemetry::TRIG_FAULT);
+    BlackBox::freeze(BlackBox::REASON_FAULT);
+    buzz.buzz(200, 255, 80, Buzzer::PRIO_ALERT);
+  }
+
+  // Stall latch is cleared once the button is released (a new press in the same direction retries)
+  if (cs.m1Dir == 0 && m1Status.stallDir != 0)
+    motor1.clearStall();
+  if (cs.m2Dir == 0 && m2Status.stallDir != 0)
+    motor2.clearStall();
+
+  // Min-duty calibration requested from the web UI
+  if (calibrateRequest)
+  {
+    DRV8874 &m = (calibrateRequest == 1) ? motor1 : motor2;
+    calibrateRequest = 0;
+    move1.active = move2.active = false;
+    m.calibrate(SLOW_PT);
+    showMessage("Calibrating...");
+  }
+  const bool calibrating = m1Status.state == MotorState::Calibrating || m2Status.state == MotorState::Calibrating;
+  if (LampTimer::beginFlashWrite()) // a finished sweep is written to NVS here, after any exposure
+  {
+    motor1.saveCalibration();
+    motor2.saveCalibration();
+    LampTimer::endFlashWrite();
+  }
+
+  // Presets: select, save, go
+  if (Controls::rising(&ControlsState::nextPreset) && lockFlashOrRefuse())
+  {
+    const uint8_t idx = Presets::selectNext();
+    LampTimer::endFlashWrite();
+    char msg[17];
+    snprintf(msg, sizeof(msg), "P%u %s%s", (unsigned)idx + 1, Presets::get(idx).name, Presets::get(idx).valid ? "" : " (empty)");
+    showMessage(msg);
+  }
+  if (Controls::rising(&ControlsState::savePreset))
+  {
+    if (!m1Status.homed || !m2Status.homed)
+    {
+      showMessage("Home motors 1st");
+      buzz.buzz(150, 255, 400);
+    }
+    else if (lockFlashOrRefuse())
+    {
+      Presets::save(Presets::selected(), m1Status.position, m2Status.position);
+      LampTimer::endFlashWrite();
+      showMessage("Preset saved");
+      buzz.buzz(60, 255, 2000);
+    }
+  }
+  if (Controls::rising(&ControlsState::goPreset))
+    startPresetMove();
+
+  // Coupled focus: toggle, capture in-focus points (hold to clear the table)
+  if (Controls::rising(&ControlsState::toggleFocusTrack))
   {
-    delayMicroseconds(200);
-    if (digitalRead(M1_FAULT) == LOW) // small debounce/filter in case of brief pulses
-      debouncedFaultM1 = true;
+    if (!focusCoupled && FocusTrack::count() < 2)
+      showMessage("Focus: need 2 pt");
+    else
+    {
+      focusCoupled = !focusCoupled;
+      prefsDirty |= PREF_FOCUS_TRACK;
+      showMessage(focusCoupled ? "Focus track ON" : "Focus track OFF");
+    }
+  }
+  static uint32_t captureHeldSinceMs = 0;
+  if (Controls::rising(&ControlsState::captureFocus))
+  {
+    captureHeldSinceMs = millis() | 1u;
+    if (!m1Status.homed || !m2Status.homed)
+    {
+      showMessage("Home motors 1st");
+      buzz.buzz(150, 255, 400);
+    }
+    else if (lockFlashOrRefuse())
+    {
+      FocusTrack::capture(m1Status.position, m2Status.position);
+      LampTimer::endFlashWrite();
+      char msg[17];
+      snprintf(msg, sizeof(msg), "Focus pt %u/%u", (unsigned)FocusTrack::count(), (unsigned)FocusTrack::MAX_POINTS);
+      showMessage(msg);
+      buzz.buzz(60, 255, 2000);
+    }
+  }
+  else if (!cs.captureFocus)
+    captureHeldSinceMs = 0;
+  else if (captureHeldSinceMs && millis() - captureHeldSinceMs > FOCUS_CLEAR_HOLD_MS)
+  {
+    captureHeldSinceMs = 0;
+    if (lockFlashOrRefuse())
+    {
+      FocusTrack::clear();
+      LampTimer::endFlashWrite();
+      focusCoupled = false;
+      prefsDirty |= PREF_FOCUS_TRACK;
+      showMessage("Focus cleared");
+      buzz.buzz(300, 255, 400);
+    }
   }
 
-  if (faultM2)
+  const bool wasMoving = move1.active || move2.active;
+  bool m1Auto = stepPresetMove(motor1, m1Status, move1, cs.m1Dir, cs.m1Conflict || faultM1);
+  bool m2Auto = stepPresetMove(motor2, m2Status, move2, cs.m2Dir, cs.m2Conflict || faultM2);
+  if (move1.aborted || move2.aborted) // one motor aborted: stop the whole move, manual control brakes the other
   {
-    delayMicroseconds(200);
-    if (digitalRead(M2_FAULT) == LOW) // small debounce/filter in case of brief pulses
-      debouncedFaultM2 = true;
+    move1.active = move2.active = false;
+    m1Auto = m2Auto = false;
+  }
+  if (wasMoving && !move1.active && !move2.active)
+  {
+    if (move1.aborted || move2.aborted)
+    {
+      showMessage("Move aborted");
+      buzz.buzz(150, 255, 400);
+    }
+    else
+    {
+      showMessage("Preset reached");
+      buzz.buzz(60, 255, 2000);
+    }
   }
 
+  // Lens follows the head unless a preset move drives it (or a calibration sweep runs)
+  if (!m2Auto && !calibrating && stepFocusTrack(m1Status, m2Status, cs.m2Dir, cs.m2Conflict || faultM2))
+    m2Auto = true;
+
   // Motor 1 command
-  if (cs.m1Conflict || debouncedFaultM1)
+  if (m1Auto)
+    ; // preset move owns the motor
+  else if (faultM1)
+    ; // outputs cut and coasted by FaultManager until recovery
+  else if (cs.m1Conflict)
   {
     motor1.coast();
-    buzz.buzz(200, 255, 80);
+    buzz.buzz(200, 255, 80, Buzzer::PRIO_ALERT);
   }
   else if (cs.m1Dir == 0 && motor1.getSpeed() != 0)
     // motor1.coast();
@@ -239,10 +920,14 @@ void loop()
   }
 
   // Motor 2 command
-  if (cs.m2Conflict || debouncedFaultM2)
+  if (m2Auto)
+    ; // preset move or focus tracking owns the motor
+  else if (faultM2)
+    ; // outputs cut and coasted by FaultManager until recovery
+  else if (cs.m2Conflict)
   {
     motor2.coast();
-    buzz.buzz(200, 255, 80);
+    buzz.buzz(200, 255, 80, Buzzer::PRIO_ALERT);
   }
   else if (cs.m2Dir == 0 && motor2.getSpeed() != 0)
     // motor2.coast();
@@ -257,42 +942,123 @@ void loop()
   if (Controls::rising(&ControlsState::Brightness))
   {
     brightness = TM1638plusWrapper::getNextBrightness(brightness); // updateDisplay will take care of it
-    prefs.putUChar("brightness", brightness);
+    prefsDirty |= PREF_BRIGHTNESS;
     Serial.printf("mainMaster: new brightness=%d\n", brightness);
   }
 
   // Start timer on rising edge only (avoid restart every loop while pressed)
   if (Controls::rising(&ControlsState::StartTimer))
   {
-    if (lamp.isOn() && timer.isRunning())
+    if (FaultManager::latchedMask()) // acknowledge the fault instead of starting an exposure
     {
-      lamp.off();
+      const bool ok = FaultManager::recover();
+      showMessage(ok ? "Fault cleared" : "Fault active");
+      buzz.buzz(ok ? 60 : 300, 255, ok ? 2000 : 400);
+    }
+    else if (exposureMode == ExposureMode::TestStrip)
+    {
+      if (strip.active && strip.exposing) // cancel: the strip is spoiled
+      {
+        LampTimer::cancel();
+        endStrip(true);
+      }
+      else if (strip.active || startStrip()) // card moved: next step
+        startStripStep();
+      else
+        buzz.buzz(300, 255, 400); // increments round to nothing
+    }
+    else if (exposureMode == ExposureMode::Program)
+    {
+      if (ExposureProgram::state() == ExposureProgram::State::Running) // cancel: the print is spoiled
+        endProgram(true);
+      else // first group, or the next one after a wait
+        startProgramGroup();
+    }
+    else if (exposureMode == ExposureMode::Metered)
+    {
+      if (metering) // cancel
+      {
+        LampTimer::cancel();
+        Serial.println("mainMaster: metered exposure cancel");
+      }
+      else
+        startMetered();
+    }
+    else if (lamp.isOn() && timer.isRunning())
+    {
+      LampTimer::cancel();
       timer.stop();
+      buzz.stopMetronome();
       Serial.println("mainMaster: Timer cancel (timer was running and lamp was on)");
     }
     else
     {
-      prefs.putULong("duration", timer.getDurationMs()); // save last used duration for next boot
+      prefsDurationMs = timer.getDurationMs();
+      prefsDirty |= PREF_DURATION | (fStopMode ? PREF_FSTOP_OFFSET : 0);
       timer.start(onTimerDone);
-      lamp.on();
+      startMetronome(timer.getDurationMs());
+      LampTimer::start(timer.getDurationMs()); // lamp on now, off from the timer ISR
       Serial.printf("mainMaster: Timer started timer.remainingMs()=%d timer.isRunning()=%d timer.getDurationMs()=%d\n",
                     (int)timer.remainingMs(), (int)timer.isRunning(), (int)timer.getDurationMs());
     }
   }
 
+  LampTimer::Exposure exposure;
+  if (LampTimer::pollFinished(exposure))
+  {
+    Serial.printf("mainMaster: exposure #%lu %s: requested %llu us, pin %llu us, error %+ld us, %lu half cycles\n",
+                  (unsigned long)exposure.seq, exposure.cancelled ? "cancelled" : "done",
+                  (unsigned long long)exposure.requestedUs, (unsigned long long)exposure.pinUs, (long)exposure.errorUs,
+                  (unsigned long)exposure.halfCycles);
+    logExposure(exposure, m1Status, m2Status);
+    onStripExposureDone(exposure);
+    onMeteredExposureDone(exposure);
+  }
+  serviceProgram();
+
   if (Controls::rising(&ControlsState::toggleLamp))
   {
-    lamp.toggle();
-    Serial.printf("toggleLamp: lamp is now %s\n", lamp.isOn() ? "ON" : "OFF");
+    const bool on = LampTimer::toggle(); // off also ends a running exposure (reported as cancelled)
+    Serial.printf("toggleLamp: lamp is now %s\n", on ? "ON" : "OFF");
+  }
+
+  const bool programActive = ExposureProgram::state() != ExposureProgram::State::Idle;
+  ExposureLog::holdWrites(strip.active || programActive);
+  if (Controls::rising(&ControlsState::cycleExposureMode) && ExposureProgram::state() == ExposureProgram::State::Waiting)
+    endProgram(true); // L3 while waiting for the next group: drop the rest of the program
+  if (Controls::rising(&ControlsState::cycleExposureMode) && !timer.isRunning() && !strip.active && !programActive)
+  {
+    exposureMode = ExposureMode((uint8_t(exposureMode) + 1) % uint8_t(ExposureMode::Count));
+    if (exposureMode == ExposureMode::Metered && !LightMeter::isAttached())
+      exposureMode = ExposureMode((uint8_t(exposureMode) + 1) % uint8_t(ExposureMode::Count));
+    prefsDirty |= PREF_EXPOSURE_MODE;
+    showMessage(EXPOSURE_MODE_NAMES[uint8_t(exposureMode)]);
+    buzz.buzz(60, 255, 2000);
+  }
+
+  if (Controls::rising(&ControlsState::toggleFStop) && !timer.isRunning() && !strip.active && !programActive)
+  {
+    fStopMode = !fStopMode;
+    if (fStopMode) // the current time becomes the base of the stop scale
+    {
+      fStopBaseMs = timer.getDurationMs();
+      fStopOffset = 0;
+      prefsDirty |= PREF_FSTOP_OFFSET;
+    }
+    prefsDirty |= PREF_FSTOP;
+    showMessage(fStopMode ? "F-stop timer" : "Linear timer");
+    buzz.buzz(60, 255, 2000);
   }
 
-  if (!timer.isRunning()) // ignore timer adjusment while it's running
+  if (!timer.isRunning() && !strip.active && !programActive) // ignore timer adjusment while it's running
   {
     uint16_t timerStep = 100;
     if (cs.Fast)
       timerStep = 1000;
     else if (cs.Insane)
       timerStep = 10000;
+    // F-stop mode: 1/12 stop, Fast 1/3, Insane 1 stop, Fast+Insane 1/6 (in twelfths)
+    const int16_t fStopStep = cs.Fast && cs.Insane ? 2 : cs.Insane ? 12 : cs.Fast ? 4 : 1;
 
     // Apply timer +/- no faster than every repeatMs while button is held
     static uint32_t nextTimerAdjustMs = 0; // 0 means immediate on next press
@@ -304,17 +1070,27 @@ void loop()
     {
       uint32_t newDuration = timer.getDurationMs();
 
-      if (cs.decreaseTimer)
+      if (fStopMode)
+      {
+        const int16_t offset = fStopOffset + (cs.increaseTimer ? fStopStep : -fStopStep);
+        const uint32_t scaled = FStop::scaleMs(fStopBaseMs, offset);
+        if (offset >= -FStop::MAX_OFFSET && offset <= FStop::MAX_OFFSET && scaled >= TIMER_MIN_MS && scaled <= TIMER_MAX_MS)
+        {
+          fStopOffset = offset;
+          newDuration = scaled;
+        }
+      }
+      else if (cs.decreaseTimer)
       {
         if (newDuration <= timerStep)
-          newDuration = 100ULL;
+          newDuration = TIMER_MIN_MS;
         else
           newDuration -= timerStep;
       }
       else if (cs.increaseTimer)
       {
-        if (newDuration + timerStep > 9999000ULL)
-          newDuration = 9999000ULL;
+        if (newDuration + timerStep > TIMER_MAX_MS)
+          newDuration = TIMER_MAX_MS;
         else
           newDuration += timerStep;
       }
@@ -328,7 +1104,8 @@ void loop()
     }
   }
 
-  updateDisplay(brightness, lamp.isOn(), motor1, motor2, timer, cs.anyDirectionConflict, debouncedFaultM1, debouncedFaultM2);
+  flushPrefs();
+  updateDisplay(brightness, lamp.isOn(), motor1, motor2, timer, cs.anyDirectionConflict, faultM1, faultM2);
 
   delay(10);
 }
@@ -97,6 +97,16 @@ static void onDisplayBroadcast(const MsgV1 &m)
   }
 }
 
+static void onMotorStatus(const MsgMotorStatusV1 &msg)
+{
+  static MsgMotorStatusV1 last{};
+  if (msg.position[0] == last.position[0] && msg.position[1] == last.position[1] && msg.flags == last.flags)
+    return;
+  last = msg;
+  Serial.printf("onMotorStatus: seq=%lu m1=%ld%s m2=%ld%s\n", (unsigned long)msg.seq,
+                (long)msg.position[0], (msg.flags & 0x01) ? "" : "?", (long)msg.position[1], (msg.flags & 0x02) ? "" : "?");
+}
+
 void onConnectionLost()
 {
   isConnected = false;
@@ -131,6 +141,7 @@ void setup()
     esp_wifi_get_channel(&pri, &sec);
     Serial.printf("[SLAVE] STA ESP NOW INIT SUCCESS. Wifi Channel: %d. esp channel: %d\n", WiFi.channel(), pri);
     DurstProto::setOnDisplayBroadcast(&onDisplayBroadcast);
+    DurstProto::setOnMotorStatus(&onMotorStatus);
     displays.displayAndBroadCastTexts(lastBroadcastedSegBrightness_, "CONNECT ",
                                       getDebugLine(), "Connecting...   ");
   }
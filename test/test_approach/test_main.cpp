@@ -0,0 +1,85 @@
+// Approach speed law, alone and closing the loop on a motor that moves at the commanded speed.
+// pio test -e native -f test_approach
+
+#include <unity.h>
+
+#include "Approach.h"
+
+namespace
+{
+  const ApproachConfig CFG; // defaults: 70 % far, 10 % slow, decelerate over 400, settle within 4
+
+  // Drives a plant moving countsPerSAt100 · speed % per 2 ms tick until the speed law stops.
+  // Returns the final position; worst overshoot past the target goes into overshoot.
+  int32_t approach(int32_t from, int32_t target, int32_t &overshoot)
+  {
+    constexpr int32_t COUNTS_PER_S_AT_100 = 4000;
+    int32_t pos = from;
+    int32_t fracMilli = 0;
+    overshoot = 0;
+    for (uint32_t tick = 0; tick < 50000; ++tick)
+    {
+      const int8_t pt = Approach::speedPt(pos, target, CFG);
+      if (pt == 0)
+        break;
+      fracMilli += int32_t(pt) * COUNTS_PER_S_AT_100 * 2 / 100; // counts·1000 per 2 ms
+      pos += fracMilli / 1000;
+      fracMilli %= 1000;
+      const int32_t past = target > from ? pos - target : target - pos;
+      overshoot = past > overshoot ? past : overshoot;
+    }
+    return pos;
+  }
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_speed_sign_follows_target()
+{
+  TEST_ASSERT_EQUAL_INT8(CFG.fastPt, Approach::speedPt(0, 5000, CFG));
+  TEST_ASSERT_EQUAL_INT8(-int8_t(CFG.fastPt), Approach::speedPt(5000, 0, CFG));
+}
+
+void test_stops_within_tolerance()
+{
+  TEST_ASSERT_EQUAL_INT8(0, Approach::speedPt(100, 100 + CFG.toleranceCounts, CFG));
+  TEST_ASSERT_EQUAL_INT8(0, Approach::speedPt(100, 100 - CFG.toleranceCounts, CFG));
+  TEST_ASSERT_TRUE(Approach::within(96, 100, CFG));
+  TEST_ASSERT_FALSE(Approach::within(95, 100, CFG));
+}
+
+void test_decelerates_linearly_to_slow_speed()
+{
+  int8_t prev = CFG.fastPt;
+  for (int32_t dist = CFG.slowdownCounts; dist > CFG.toleranceCounts; --dist)
+  {
+    const int8_t pt = Approach::speedPt(0, dist, CFG);
+    TEST_ASSERT_LESS_OR_EQUAL_INT32(prev, pt);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT32(CFG.slowPt, pt);
+    prev = pt;
+  }
+  TEST_ASSERT_EQUAL_INT8(CFG.slowPt + (CFG.fastPt - CFG.slowPt) / 2, Approach::speedPt(0, CFG.slowdownCounts / 2, CFG));
+}
+
+void test_closed_loop_settles_without_overshoot()
+{
+  int32_t overshoot;
+  int32_t pos = approach(0, 12000, overshoot);
+  TEST_ASSERT_TRUE(Approach::within(pos, 12000, CFG));
+  TEST_ASSERT_LESS_OR_EQUAL_INT32(CFG.toleranceCounts, overshoot);
+
+  pos = approach(12000, -300, overshoot);
+  TEST_ASSERT_TRUE(Approach::within(pos, -300, CFG));
+  TEST_ASSERT_LESS_OR_EQUAL_INT32(CFG.toleranceCounts, overshoot);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_speed_sign_follows_target);
+  RUN_TEST(test_stops_within_tolerance);
+  RUN_TEST(test_decelerates_linearly_to_slow_speed);
+  RUN_TEST(test_closed_loop_settles_without_overshoot);
+  return UNITY_END();
+}
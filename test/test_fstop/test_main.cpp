@@ -0,0 +1,82 @@
+// FStop fixed-point table and scaling against pow().
+// pio test -e native -f test_fstop
+
+#include <math.h>
+#include <unity.h>
+
+#include "FStop.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_table_matches_pow()
+{
+  for (int k = 0; k < FStop::TWELFTHS_PER_STOP; ++k)
+    TEST_ASSERT_UINT32_WITHIN(1, uint32_t(lround(65536.0 * pow(2.0, k / 12.0))), FStop::POW2_TWELFTHS_Q16[k]);
+}
+
+void test_whole_stops_double_and_halve()
+{
+  TEST_ASSERT_EQUAL_UINT32(10000, FStop::scaleMs(10000, 0));
+  TEST_ASSERT_EQUAL_UINT32(20000, FStop::scaleMs(10000, 12));
+  TEST_ASSERT_EQUAL_UINT32(80000, FStop::scaleMs(10000, 36));
+  TEST_ASSERT_EQUAL_UINT32(5000, FStop::scaleMs(10000, -12));
+  TEST_ASSERT_EQUAL_UINT32(1250, FStop::scaleMs(10000, -36));
+}
+
+void test_every_offset_within_rounding_of_pow()
+{
+  const uint32_t bases[] = {100, 1000, 7300, 60000, 9999000};
+  for (uint32_t base : bases)
+    for (int16_t t = -FStop::MAX_OFFSET; t <= FStop::MAX_OFFSET; ++t)
+    {
+      const double exact = base * pow(2.0, t / 12.0);
+      if (exact >= double(UINT32_MAX))
+        TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, FStop::scaleMs(base, t)); // saturates
+      else // Q16 table: 1 ms of rounding plus the table's relative error
+        TEST_ASSERT_FLOAT_WITHIN(1.0 + exact * 2e-5, exact, double(FStop::scaleMs(base, t)));
+    }
+}
+
+void test_negative_offsets_floor_to_the_stop_below()
+{
+  // -1/12 stop is one stop down and 11/12 up: the same as scaling by 2^(-1/12)
+  TEST_ASSERT_EQUAL_UINT32(uint32_t(lround(12000 * pow(2.0, -1 / 12.0))), FStop::scaleMs(12000, -1));
+  TEST_ASSERT_EQUAL_UINT32(uint32_t(lround(12000 * pow(2.0, -13 / 12.0))), FStop::scaleMs(12000, -13));
+}
+
+void test_long_times_saturate_instead_of_wrapping()
+{
+  TEST_ASSERT_EQUAL_UINT32(4096000u * 512u, FStop::scaleMs(4096000, FStop::MAX_OFFSET));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, FStop::scaleMs(9999000, FStop::MAX_OFFSET));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, FStop::scaleMs(UINT32_MAX, 12));
+}
+
+void test_split_for_display()
+{
+  char sign;
+  uint8_t stops, hundredths;
+  FStop::split(-16, sign, stops, hundredths);
+  TEST_ASSERT_EQUAL('-', sign);
+  TEST_ASSERT_EQUAL_UINT8(1, stops);
+  TEST_ASSERT_EQUAL_UINT8(33, hundredths);
+  FStop::split(8, sign, stops, hundredths);
+  TEST_ASSERT_EQUAL('+', sign);
+  TEST_ASSERT_EQUAL_UINT8(0, stops);
+  TEST_ASSERT_EQUAL_UINT8(67, hundredths);
+  FStop::split(0, sign, stops, hundredths);
+  TEST_ASSERT_EQUAL('+', sign);
+  TEST_ASSERT_EQUAL_UINT8(0, hundredths);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_table_matches_pow);
+  RUN_TEST(test_whole_stops_double_and_halve);
+  RUN_TEST(test_every_offset_within_rounding_of_pow);
+  RUN_TEST(test_negative_offsets_floor_to_the_stop_below);
+  RUN_TEST(test_long_times_saturate_instead_of_wrapping);
+  RUN_TEST(test_split_for_display);
+  return UNITY_END();
+}
@@ -0,0 +1,94 @@
+// LampModel: light delivered by an on-time and its inverse, for ideal, glow-only and slow lamps.
+// pio test -e native -f test_lamp_model
+
+#include <unity.h>
+
+#include "LampModel.h"
+
+namespace
+{
+  LampModel lamp(uint16_t riseUs, uint16_t fallUs)
+  {
+    LampModel m;
+    m.riseUs = riseUs;
+    m.fallUs = fallUs;
+    return m;
+  }
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_ideal_lamp_is_identity()
+{
+  const LampModel m;
+  TEST_ASSERT_TRUE(m.isIdeal());
+  TEST_ASSERT_EQUAL_UINT64(0, m.lightUs(0));
+  TEST_ASSERT_EQUAL_UINT64(12345, m.lightUs(12345));
+  TEST_ASSERT_EQUAL_UINT64(12345, m.pinUsFor(12345));
+}
+
+void test_glow_only_adds_fall()
+{
+  const LampModel m = lamp(0, 3000);
+  TEST_ASSERT_EQUAL_UINT64(13000, m.lightUs(10000));
+  TEST_ASSERT_EQUAL_UINT64(10000, m.pinUsFor(13000));
+  TEST_ASSERT_EQUAL_UINT64(0, m.pinUsFor(2000)); // the afterglow alone is more than asked for
+}
+
+void test_settled_exposure_loses_rise_minus_fall()
+{
+  const LampModel m = lamp(50000, 20000);
+  TEST_ASSERT_EQUAL_UINT64(1000000 - 30000, m.lightUs(1000000));
+  TEST_ASSERT_EQUAL_UINT64(1000000, m.pinUsFor(1000000 - 30000));
+  // Hours long: integer path, no float rounding
+  TEST_ASSERT_EQUAL_UINT64(7200000000ull - 30000, m.lightUs(7200000000ull));
+  TEST_ASSERT_EQUAL_UINT64(7200000000ull, m.pinUsFor(7200000000ull - 30000));
+}
+
+void test_short_exposure_loses_relatively_more()
+{
+  const LampModel m = lamp(50000, 20000);
+  const uint64_t shortLight = m.lightUs(50000);
+  const uint64_t longLight = m.lightUs(5000000);
+  TEST_ASSERT_TRUE(shortLight < 50000);
+  TEST_ASSERT_TRUE(50000 - shortLight < 30000);
+  // Relative loss: short > long
+  TEST_ASSERT_TRUE((50000 - shortLight) * 5000000 > (5000000 - longLight) * 50000);
+}
+
+void test_light_is_monotonic()
+{
+  const LampModel m = lamp(60000, 10000);
+  uint64_t prev = 0;
+  for (uint64_t p = 1000; p <= 2000000; p += 1000)
+  {
+    const uint64_t l = m.lightUs(p);
+    TEST_ASSERT_TRUE(l >= prev);
+    prev = l;
+  }
+}
+
+void test_pin_for_inverts_light()
+{
+  const LampModel lamps[] = {lamp(50000, 20000), lamp(60000, 5000), lamp(20000, 30000)};
+  for (const LampModel &m : lamps)
+    for (uint64_t p = 20000; p <= 3000000; p = p * 3 / 2)
+    {
+      const uint64_t light = m.lightUs(p);
+      // Float Newton in the rise region: within a few µs per 10 ms
+      TEST_ASSERT_UINT64_WITHIN(2 + p / 5000, p, m.pinUsFor(light));
+    }
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_ideal_lamp_is_identity);
+  RUN_TEST(test_glow_only_adds_fall);
+  RUN_TEST(test_settled_exposure_loses_rise_minus_fall);
+  RUN_TEST(test_short_exposure_loses_relatively_more);
+  RUN_TEST(test_light_is_monotonic);
+  RUN_TEST(test_pin_for_inverts_light);
+  return UNITY_END();
+}
@@ -0,0 +1,96 @@
+// MotionProfile ramps at the control task tick.
+// pio test -e native -f test_motion_profile
+
+#include <unity.h>
+
+#include "MotionProfile.h"
+
+namespace
+{
+  constexpr uint32_t TICK_US = 2000; // CTRL_UPDATE_HZ = 500
+  constexpr int32_t MILLI = MotionProfile::MILLI_PCT_PER_PCT;
+
+  int32_t absI(int32_t v) { return v < 0 ? -v : v; }
+
+  // Steps from `from` to `to` and checks the limits on every tick. Returns the ticks taken.
+  uint32_t ramp(int8_t from, int8_t to, const MotionLimits &lim)
+  {
+    MotionState s{int32_t(from) * MILLI, 0};
+    const int32_t target = int32_t(to) * MILLI;
+    const int32_t dvMax = int32_t(int64_t(lim.accelPctPerS) * MILLI * TICK_US / 1000000);
+    const int32_t daMax = int32_t(int64_t(lim.jerkPctPerS2) * MILLI * TICK_US / 1000000);
+    uint32_t ticks = 0;
+    while (!MotionProfile::atTarget(s, to) && ticks < 100000)
+    {
+      const MotionState prev = s;
+      s = MotionProfile::step(s, to, lim, TICK_US);
+      ticks++;
+      // Never past the target
+      if (to >= from)
+        TEST_ASSERT_LESS_OR_EQUAL_INT32(target, s.velMilliPct);
+      else
+        TEST_ASSERT_GREATER_OR_EQUAL_INT32(target, s.velMilliPct);
+      TEST_ASSERT_LESS_OR_EQUAL_INT32(dvMax, absI(s.velMilliPct - prev.velMilliPct));
+      TEST_ASSERT_LESS_OR_EQUAL_INT32(int32_t(lim.accelPctPerS) * MILLI, absI(s.accMilliPctPerS));
+      if (lim.jerkPctPerS2 && !MotionProfile::atTarget(s, to)) // the final snap may drop the acceleration
+        TEST_ASSERT_LESS_OR_EQUAL_INT32(daMax, absI(s.accMilliPctPerS - prev.accMilliPctPerS));
+    }
+    return ticks;
+  }
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_unlimited_jumps_to_target()
+{
+  const MotionState s = MotionProfile::step(MotionState{}, 80, MotionLimits{}, TICK_US);
+  TEST_ASSERT_TRUE(MotionProfile::atTarget(s, 80));
+}
+
+void test_trapezoid_takes_speed_over_accel()
+{
+  MotionLimits lim;
+  lim.accelPctPerS = 200;
+  // 0 → 100 % at 200 %/s: 0.5 s = 250 ticks
+  TEST_ASSERT_UINT32_WITHIN(1, 250, ramp(0, 100, lim));
+  TEST_ASSERT_UINT32_WITHIN(1, 250, ramp(100, 0, lim));
+}
+
+void test_trapezoid_reverses_through_zero()
+{
+  MotionLimits lim;
+  lim.accelPctPerS = 200;
+  TEST_ASSERT_UINT32_WITHIN(1, 250, ramp(50, -50, lim)); // 100 % of change, like 0 → 100
+}
+
+void test_s_curve_adds_accel_over_jerk()
+{
+  MotionLimits lim;
+  lim.accelPctPerS = 200;
+  lim.jerkPctPerS2 = 2000;
+  // Reaches full acceleration: v/a + a/j = 0.5 s + 0.1 s = 300 ticks
+  TEST_ASSERT_UINT32_WITHIN(3, 300, ramp(0, 100, lim));
+  TEST_ASSERT_UINT32_WITHIN(3, 300, ramp(60, -40, lim));
+}
+
+void test_s_curve_short_move_never_overshoots()
+{
+  MotionLimits lim;
+  lim.accelPctPerS = 200;
+  lim.jerkPctPerS2 = 500; // too short a change to reach full acceleration
+  const uint32_t ticks = ramp(0, 5, lim);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, ticks);
+  TEST_ASSERT_LESS_THAN_UINT32(100000, ticks);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_unlimited_jumps_to_target);
+  RUN_TEST(test_trapezoid_takes_speed_over_accel);
+  RUN_TEST(test_trapezoid_reverses_through_zero);
+  RUN_TEST(test_s_curve_adds_accel_over_jerk);
+  RUN_TEST(test_s_curve_short_move_never_overshoots);
+  return UNITY_END();
+}
@@ -0,0 +1,129 @@
+// RippleCounter on synthetic CS samples and PositionEstimator against a motor whose speed is
+// proportional to the duty above min duty.
+// pio test -e native -f test_position_estimator
+
+#include <math.h>
+#include <unity.h>
+
+#include "PositionEstimator.h"
+#include "RippleCounter.h"
+
+namespace
+{
+  constexpr uint32_t SAMPLE_HZ = 10000; // CS conversions per pin
+  constexpr uint32_t TICK_US = 2000;    // CTRL_UPDATE_HZ = 500
+  constexpr uint32_t MAX_DUTY = 1023;
+  constexpr uint32_t MIN_DUTY = 563;    // ~55 %, the dead band of the real motors
+  constexpr uint32_t RATE_AT_MAX = 2000; // true ripple counts per second at MAX_DUTY
+
+  // CS samples: DC level plus a ripple of `amplitude` raw counts at rippleHz, and a little noise
+  uint32_t countRipple(float dc, float amplitude, float rippleHz, float seconds)
+  {
+    RippleCounter rc;
+    rc.configure(RippleCounterConfig{});
+    const uint32_t n = uint32_t(seconds * SAMPLE_HZ);
+    uint32_t noise = 12345;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+      noise = noise * 1103515245u + 12345u;
+      const float x = dc + amplitude * sinf(2.0f * float(M_PI) * rippleHz * float(i) / SAMPLE_HZ) +
+                      float(int32_t(noise >> 28) - 8) * 0.5f; // ±4 counts
+      rc.sample(uint16_t(x));
+    }
+    return rc.edges();
+  }
+
+  // Drives the estimator for `seconds` at duty, counting true motion; ripple edges are fed when
+  // `ripple` is set. Returns the true travel in counts.
+  float drive(PositionEstimator &pe, uint32_t &edges, int8_t dir, uint32_t duty, bool ripple, float seconds)
+  {
+    const float countsPerTick =
+        duty > MIN_DUTY ? float(RATE_AT_MAX) * float(duty - MIN_DUTY) / float(MAX_DUTY - MIN_DUTY) * TICK_US / 1e6f
+                        : 0.0f;
+    float acc = 0, travel = 0;
+    for (uint32_t i = 0; i < uint32_t(seconds * 1e6f / TICK_US); ++i)
+    {
+      acc += countsPerTick;
+      const uint32_t whole = uint32_t(acc);
+      acc -= float(whole);
+      travel += float(whole);
+      if (ripple)
+        edges += whole;
+      pe.update(dir, duty, MIN_DUTY, MAX_DUTY, edges, ripple, TICK_US);
+    }
+    return dir * travel;
+  }
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_ripple_edges_counted_once_per_period()
+{
+  TEST_ASSERT_UINT32_WITHIN(2, 200, countRipple(600.0f, 40.0f, 200.0f, 1.0f));
+  TEST_ASSERT_UINT32_WITHIN(5, 1000, countRipple(600.0f, 40.0f, 1000.0f, 1.0f));
+}
+
+void test_ripple_ignores_noise_and_dc()
+{
+  TEST_ASSERT_EQUAL_UINT32(0, countRipple(600.0f, 0.0f, 0.0f, 1.0f));
+}
+
+void test_ripple_counts_edges_in_driven_direction()
+{
+  PositionEstimator pe;
+  pe.configure(PositionConfig{});
+  uint32_t edges = 0;
+  const float fwd = drive(pe, edges, 1, MAX_DUTY, true, 1.0f);
+  TEST_ASSERT_INT32_WITHIN(1, int32_t(fwd), pe.position());
+  const float back = drive(pe, edges, -1, MAX_DUTY, true, 0.5f);
+  TEST_ASSERT_INT32_WITHIN(1, int32_t(fwd + back), pe.position());
+  TEST_ASSERT_TRUE(pe.usingRipple());
+}
+
+void test_rate_learned_above_min_duty()
+{
+  PositionEstimator pe;
+  pe.configure(PositionConfig{});
+  uint32_t edges = 0;
+  drive(pe, edges, 1, 800, true, 3.0f); // mid speed: only the duty above min duty moves the shaft
+  TEST_ASSERT_UINT32_WITHIN(RATE_AT_MAX / 50, RATE_AT_MAX, pe.rateCountsPerS());
+}
+
+void test_fallback_tracks_crawl_speed()
+{
+  PositionEstimator pe;
+  pe.configure(PositionConfig{});
+  uint32_t edges = 0;
+  float travel = drive(pe, edges, 1, MAX_DUTY, true, 2.0f); // learn the rate
+  const int32_t before = pe.position();
+  // Crawl, ripple gone: ~7 % of full speed although the duty is ~59 %
+  const float crawl = drive(pe, edges, 1, 600, false, 4.0f);
+  travel += crawl;
+  TEST_ASSERT_FALSE(pe.usingRipple());
+  TEST_ASSERT_INT32_WITHIN(int32_t(crawl * 0.05f) + 2, int32_t(crawl), pe.position() - before);
+  TEST_ASSERT_INT32_WITHIN(int32_t(travel * 0.02f) + 2, int32_t(travel), pe.position());
+}
+
+void test_fallback_stands_still_in_dead_band()
+{
+  PositionConfig cfg;
+  cfg.countsPerSAtMax = RATE_AT_MAX;
+  PositionEstimator pe;
+  pe.configure(cfg);
+  uint32_t edges = 0;
+  drive(pe, edges, -1, MIN_DUTY, false, 2.0f);
+  TEST_ASSERT_EQUAL_INT32(0, pe.position());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_ripple_edges_counted_once_per_period);
+  RUN_TEST(test_ripple_ignores_noise_and_dc);
+  RUN_TEST(test_ripple_counts_edges_in_driven_direction);
+  RUN_TEST(test_rate_learned_above_min_duty);
+  RUN_TEST(test_fallback_tracks_crawl_speed);
+  RUN_TEST(test_fallback_stands_still_in_dead_band);
+  return UNITY_END();
+}
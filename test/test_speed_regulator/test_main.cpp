@@ -0,0 +1,140 @@
+// SpeedRegulator against the DcMotorModel plant, run like the DRV8874 control task
+// (500 Hz, regulator fed the duty and current of the previous tick).
+// pio test -e native -f test_speed_regulator
+
+#include <unity.h>
+
+#include "DcMotorModel.h"
+#include "SpeedRegulator.h"
+
+namespace
+{
+  constexpr uint32_t MAX_DUTY = 1023;        // 10-bit PWM, as DRV8874.h
+  constexpr float TICK_S = 0.002f;           // CTRL_UPDATE_HZ = 500
+  constexpr uint32_t FF_DUTY = 700;          // ~68 %, well above min duty
+  constexpr float LOAD_NM = 0.01f;           // ~1/6 of the model's stall torque
+  constexpr uint32_t TICKS = 750;            // 1.5 s after each step
+
+  struct Run
+  {
+    float noLoadRadS = 0; // speed before the step
+    float finalRadS = 0;  // speed at the end
+    float minRadS = 0;    // lowest after the step
+    float maxRadS = 0;    // highest after the step
+    uint32_t settleMs = 0; // last time outside ±2 % of the no-load speed around the final speed
+  };
+
+  SpeedRegulatorConfig config(const DcMotorModel &m)
+  {
+    SpeedRegulatorConfig cfg;
+    cfg.enabled = true;
+    // R * MAX_DUTY / V = 341; set ~12 % low as recommended in SpeedRegulator.h
+    cfg.irCompDutyPerA = 300;
+    cfg.noLoadmA = m.currentmA();
+    cfg.kpQ8 = 512;
+    cfg.kiQ8 = 32;
+    cfg.maxTrimDuty = 300;
+    return cfg;
+  }
+
+  // Spins the motor up at FF_DUTY without load, then steps the load from loadBefore to loadAfter
+  Run run(bool regulated, float loadBefore, float loadAfter)
+  {
+    DcMotorModel m;
+    for (uint32_t i = 0; i < TICKS; ++i)
+      m.stepDuty(FF_DUTY, 1, MAX_DUTY, TICK_S);
+    const SpeedRegulatorConfig cfg = config(m);
+    Run r;
+    r.noLoadRadS = m.speedRadS;
+
+    SpeedRegulator reg;
+    uint32_t duty = FF_DUTY;
+    m.loadNm = loadBefore;
+    for (uint32_t i = 0; i < TICKS; ++i) // settle on the first load
+    {
+      if (regulated)
+        duty = reg.update(cfg, FF_DUTY, duty, m.currentmA(), MAX_DUTY);
+      m.stepDuty(duty, 1, MAX_DUTY, TICK_S);
+    }
+
+    static float speeds[TICKS];
+    m.loadNm = loadAfter;
+    for (uint32_t i = 0; i < TICKS; ++i)
+    {
+      if (regulated)
+        duty = reg.update(cfg, FF_DUTY, duty, m.currentmA(), MAX_DUTY);
+      m.stepDuty(duty, 1, MAX_DUTY, TICK_S);
+      speeds[i] = m.speedRadS;
+    }
+    r.finalRadS = speeds[TICKS - 1];
+    r.minRadS = r.maxRadS = speeds[0];
+    for (uint32_t i = 0; i < TICKS; ++i)
+    {
+      r.minRadS = speeds[i] < r.minRadS ? speeds[i] : r.minRadS;
+      r.maxRadS = speeds[i] > r.maxRadS ? speeds[i] : r.maxRadS;
+      if (fabsf(speeds[i] - r.finalRadS) > 0.02f * r.noLoadRadS)
+        r.settleMs = uint32_t((i + 1) * TICK_S * 1000.0f + 0.5f);
+    }
+    return r;
+  }
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_no_load_keeps_feed_forward_duty()
+{
+  DcMotorModel m;
+  for (uint32_t i = 0; i < TICKS; ++i)
+    m.stepDuty(FF_DUTY, 1, MAX_DUTY, TICK_S);
+  const SpeedRegulatorConfig cfg = config(m);
+  SpeedRegulator reg;
+  uint32_t duty = FF_DUTY;
+  for (uint32_t i = 0; i < TICKS; ++i)
+  {
+    duty = reg.update(cfg, FF_DUTY, duty, m.currentmA(), MAX_DUTY);
+    m.stepDuty(duty, 1, MAX_DUTY, TICK_S);
+  }
+  TEST_ASSERT_UINT32_WITHIN(2, FF_DUTY, duty);
+}
+
+void test_open_loop_sags_under_load()
+{
+  // The load step is big enough to matter without regulation
+  const Run r = run(false, 0.0f, LOAD_NM);
+  TEST_ASSERT_LESS_THAN(0.80f * r.noLoadRadS, r.finalRadS);
+}
+
+void test_load_step_settles_near_no_load_speed()
+{
+  const Run r = run(true, 0.0f, LOAD_NM);
+  TEST_ASSERT_GREATER_THAN(0.95f * r.noLoadRadS, r.finalRadS); // under-compensated IR: a small droop remains
+  TEST_ASSERT_GREATER_THAN(0.85f * r.noLoadRadS, r.minRadS);   // dip while the integrator catches up
+  TEST_ASSERT_LESS_OR_EQUAL(150, r.settleMs);
+}
+
+void test_load_step_does_not_overshoot()
+{
+  const Run r = run(true, 0.0f, LOAD_NM);
+  TEST_ASSERT_LESS_OR_EQUAL(r.finalRadS + 0.02f * r.noLoadRadS, r.maxRadS);
+}
+
+void test_load_release_settles_without_overshoot()
+{
+  // Trim built up under load has to unwind when the load goes away
+  const Run r = run(true, LOAD_NM, 0.0f);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f * r.noLoadRadS, r.noLoadRadS, r.finalRadS);
+  TEST_ASSERT_LESS_OR_EQUAL(1.10f * r.noLoadRadS, r.maxRadS);
+  TEST_ASSERT_LESS_OR_EQUAL(150, r.settleMs);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_no_load_keeps_feed_forward_duty);
+  RUN_TEST(test_open_loop_sags_under_load);
+  RUN_TEST(test_load_step_settles_near_no_load_speed);
+  RUN_TEST(test_load_step_does_not_overshoot);
+  RUN_TEST(test_load_release_settles_without_overshoot);
+  return UNITY_END();
+}
@@ -0,0 +1,82 @@
+// TestStrip timelines: step sums hit the cumulative times exactly, linear and f-stop spacing.
+// pio test -e native -f test_test_strip
+
+#include <math.h>
+#include <unity.h>
+
+#include "TestStrip.h"
+
+namespace
+{
+  // Light strip i receives: steps 0 .. i
+  uint32_t stripTotal(const uint32_t (&stepMs)[TestStrip::MAX_STEPS], uint8_t i)
+  {
+    uint32_t sum = 0;
+    for (uint8_t k = 0; k <= i; ++k)
+      sum += stepMs[k];
+    return sum;
+  }
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_linear_steps()
+{
+  TestStripConfig cfg; // 6 × 5 s
+  uint32_t steps[TestStrip::MAX_STEPS];
+  TEST_ASSERT_EQUAL_UINT8(6, TestStrip::build(cfg, steps));
+  for (uint8_t i = 0; i < 6; ++i)
+  {
+    TEST_ASSERT_EQUAL_UINT32(5000, steps[i]);
+    TEST_ASSERT_EQUAL_UINT32(5000u * (i + 1), stripTotal(steps, i));
+  }
+}
+
+void test_f_stop_strips_get_exact_rounded_totals()
+{
+  TestStripConfig cfg;
+  cfg.fStop = true;
+  cfg.baseMs = 7300;
+  cfg.incrementTwelfths = 4; // 1/3 stop
+  cfg.steps = 12;
+  uint32_t steps[TestStrip::MAX_STEPS];
+  TEST_ASSERT_EQUAL_UINT8(12, TestStrip::build(cfg, steps));
+  for (uint8_t i = 0; i < 12; ++i)
+  {
+    // No drift: every strip has exactly its own rounded cumulative time
+    TEST_ASSERT_EQUAL_UINT32(TestStrip::cumulativeMs(cfg, i), stripTotal(steps, i));
+    TEST_ASSERT_UINT32_WITHIN(1, uint32_t(lround(7300 * pow(2.0, i / 3.0))), stripTotal(steps, i));
+  }
+}
+
+void test_steps_clamped_to_max()
+{
+  TestStripConfig cfg;
+  cfg.steps = 40;
+  uint32_t steps[TestStrip::MAX_STEPS];
+  TEST_ASSERT_EQUAL_UINT8(TestStrip::MAX_STEPS, TestStrip::build(cfg, steps));
+}
+
+void test_vanishing_increment_builds_nothing()
+{
+  TestStripConfig cfg;
+  cfg.incrementMs = 0;
+  uint32_t steps[TestStrip::MAX_STEPS];
+  TEST_ASSERT_EQUAL_UINT8(0, TestStrip::build(cfg, steps));
+
+  cfg.fStop = true;
+  cfg.baseMs = 1; // 1/12 stop of 1 ms rounds to the same ms
+  cfg.incrementTwelfths = 1;
+  TEST_ASSERT_EQUAL_UINT8(0, TestStrip::build(cfg, steps));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_linear_steps);
+  RUN_TEST(test_f_stop_strips_get_exact_rounded_totals);
+  RUN_TEST(test_steps_clamped_to_max);
+  RUN_TEST(test_vanishing_increment_builds_nothing);
+  return UNITY_END();
+}
@@ -0,0 +1,103 @@
+// ZeroCrossTracker fed with simulated detector edges: lock, frequency tracking, bounce, missed
+// edges and crossing prediction.
+// pio test -e native -f test_zero_cross
+
+#include <unity.h>
+
+#include "ZeroCross.h"
+
+namespace
+{
+  uint32_t s_noise = 1;
+
+  // ±jitterUs pseudo-random
+  int32_t jitter(int32_t jitterUs)
+  {
+    s_noise = s_noise * 1103515245u + 12345u;
+    return jitterUs ? int32_t((s_noise >> 16) % uint32_t(2 * jitterUs + 1)) - jitterUs : 0;
+  }
+
+  // Feeds n crossings of a halfUs half period starting at t; returns the time of the next one
+  uint64_t feed(ZeroCrossTracker &zc, uint64_t t, uint32_t halfUs, uint32_t n, int32_t jitterUs = 20)
+  {
+    for (uint32_t i = 0; i < n; ++i, t += halfUs)
+      zc.edge(t + jitter(jitterUs));
+    return t;
+  }
+} // namespace
+
+void setUp() { s_noise = 1; }
+void tearDown() {}
+
+void test_locks_after_lock_edges()
+{
+  ZeroCrossTracker zc;
+  zc.configure(ZeroCrossConfig{});
+  uint64_t t = feed(zc, 1000000, 10000, 10);
+  TEST_ASSERT_FALSE(zc.locked(t));
+  t = feed(zc, t, 10000, 10);
+  TEST_ASSERT_TRUE(zc.locked(t));
+  TEST_ASSERT_UINT32_WITHIN(5, 10000, zc.halfPeriodUs());
+}
+
+void test_tracks_off_nominal_mains()
+{
+  ZeroCrossTracker zc;
+  zc.configure(ZeroCrossConfig{});
+  feed(zc, 1000000, 10101, 400); // 49.5 Hz
+  TEST_ASSERT_UINT32_WITHIN(3, 10101, zc.halfPeriodUs());
+
+  ZeroCrossConfig cfg;
+  cfg.mainsHz = 60;
+  zc.configure(cfg);
+  feed(zc, 1000000, 8333, 400);
+  TEST_ASSERT_UINT32_WITHIN(3, 8333, zc.halfPeriodUs());
+}
+
+void test_rejects_bounce_and_bridges_missed_edges()
+{
+  ZeroCrossTracker zc;
+  zc.configure(ZeroCrossConfig{});
+  uint64_t t = feed(zc, 1000000, 10000, 40, 0);
+  TEST_ASSERT_FALSE(zc.edge(t - 10000 + 300)); // bounce right after the last crossing
+  TEST_ASSERT_EQUAL_UINT64(t - 10000, zc.lastCrossingUs());
+  t += 2 * 10000;                               // two edges missed
+  TEST_ASSERT_TRUE(zc.edge(t));
+  TEST_ASSERT_TRUE(zc.locked(t));
+  TEST_ASSERT_UINT32_WITHIN(1, 10000, zc.halfPeriodUs());
+}
+
+void test_loses_lock_when_edges_stop()
+{
+  ZeroCrossTracker zc;
+  zc.configure(ZeroCrossConfig{});
+  const uint64_t t = feed(zc, 1000000, 10000, 40);
+  TEST_ASSERT_TRUE(zc.locked(t));
+  TEST_ASSERT_FALSE(zc.locked(t + 10 * 10000));
+}
+
+void test_predicts_crossings()
+{
+  ZeroCrossTracker zc;
+  zc.configure(ZeroCrossConfig{});
+  const uint64_t t = feed(zc, 1000000, 10000, 200, 0);
+  const uint64_t last = t - 10000;
+  TEST_ASSERT_EQUAL_UINT64(last + 10000, zc.nextCrossing(last + 1));
+  TEST_ASSERT_EQUAL_UINT64(last + 30000, zc.nextCrossing(last + 25000));
+  TEST_ASSERT_EQUAL_UINT32(3, zc.halfCyclesSinceLast(last + 29000));
+  // 9999 s of half cycles (the longest exposure) still lands on a crossing
+  const uint32_t n = 999900;
+  TEST_ASSERT_EQUAL_UINT32(n, zc.halfCyclesSinceLast(zc.crossingAfterLast(n)));
+  TEST_ASSERT_UINT64_WITHIN(uint64_t(n) / 100, last + uint64_t(n) * 10000, zc.crossingAfterLast(n));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_locks_after_lock_edges);
+  RUN_TEST(test_tracks_off_nominal_mains);
+  RUN_TEST(test_rejects_bounce_and_bridges_missed_edges);
+  RUN_TEST(test_loses_lock_when_edges_stop);
+  RUN_TEST(test_predicts_crossings);
+  return UNITY_END();
+}